@@ -0,0 +1,62 @@
+// Runs a command and writes its exit code, wall time and peak RSS to a file:
+//
+//     measure RESULT_PATH COMMAND [ARGUMENT...]
+//
+// The runner can't measure the peak RSS itself: a process forked from it
+// starts out with the runner's memory and keeps that as its high-water mark
+// across exec. This one is small, so the processes it forks aren't skewed.
+
+// For wait4().
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: measure RESULT_PATH COMMAND [ARGUMENT...]\n");
+        return 64;
+    }
+
+    struct timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    pid_t const pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 71;
+    }
+    if (pid == 0) {
+        execvp(argv[2], &argv[2]);
+        perror(argv[2]);
+        _exit(127);
+    }
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("wait4");
+        return 71;
+    }
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const wall = (double)(end.tv_sec - begin.tv_sec) +
+                        (double)(end.tv_nsec - begin.tv_nsec) / 1e9;
+    int const exit_code =
+        WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+    FILE* result = fopen(argv[1], "w");
+    if (result == NULL) {
+        perror(argv[1]);
+        return 73;
+    }
+    // ru_maxrss is in KiB on Linux.
+    fprintf(result, "%d %.9f %ld\n", exit_code, wall, usage.ru_maxrss);
+    fclose(result);
+    return exit_code;
+}
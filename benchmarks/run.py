@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+"""Runs the Lox benchmark corpus under jlox and clox and records the results.
+
+Every program in corpus/, plus the large ones generated into build/, is a
+single expression, the subset of Lox both implementations run. jlox prints
+the value of the expression, clox gets it wrapped in a print statement. The
+outputs of the two have to agree.
+
+For each program and implementation the runner records the median wall time
+of --runs runs, the instructions retired (with `perf stat`, when it works
+here) and the peak RSS, which measure.c reads for it. Results are printed and appended to
+results/history.csv and results/history.jsonl, tagged with the commit.
+
+Both implementations are built in release mode first: jlox with cargo and
+clox with -O2 -DNDEBUG, without the sanitizer and tracing of its debug build.
+--jlox and --clox run existing binaries instead.
+
+    python3 benchmarks/run.py [--runs N] [--filter TEXT] [--jlox PATH]
+                              [--clox PATH]
+
+Exits with 1 if a program fails or the outputs differ.
+"""
+
+import argparse
+import csv
+import datetime
+import glob
+import json
+import os
+import random
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BENCHMARKS = os.path.join(ROOT, "benchmarks")
+BUILD = os.path.join(BENCHMARKS, "build")
+RESULTS = os.path.join(BENCHMARKS, "results")
+
+FIELDS = [
+    "timestamp",
+    "commit",
+    "benchmark",
+    "implementation",
+    "bytes",
+    "runs",
+    "wall_seconds",
+    "instructions",
+    "max_rss_kb",
+    "outputs_match",
+]
+
+
+def build_jlox():
+    subprocess.run(
+        ["cargo", "build", "--release", "--quiet", "--manifest-path",
+         os.path.join(ROOT, "jlox", "Cargo.toml")],
+        check=True)
+    return os.path.join(ROOT, "jlox", "target", "release", "jlox")
+
+
+def build_clox():
+    path = os.path.join(BUILD, "clox")
+    sources = sorted(glob.glob(os.path.join(ROOT, "clox", "src", "*.c")))
+    compiler = os.environ.get("CC", "cc")
+    subprocess.run(
+        [compiler, "-std=c99", "-O2", "-DNDEBUG", "-o", path] + sources +
+        ["-pthread"],
+        check=True)
+    return path
+
+
+def build_measure():
+    path = os.path.join(BUILD, "measure")
+    compiler = os.environ.get("CC", "cc")
+    subprocess.run(
+        [compiler, "-std=c99", "-O2", "-o", path,
+         os.path.join(BENCHMARKS, "measure.c")],
+        check=True)
+    return path
+
+
+def balanced(rng, depth, leaf, operators):
+    """Expression that is a balanced tree of `depth` levels, so that even
+    huge ones don't nest deeper than that."""
+    if depth == 0:
+        return leaf(rng)
+    return "({} {} {})".format(balanced(rng, depth - 1, leaf, operators),
+                               rng.choice(operators),
+                               balanced(rng, depth - 1, leaf, operators))
+
+
+def generate():
+    """Writes the large programs, which are too big to keep in the repo.
+    They're generated from fixed seeds, so every run measures the same
+    code."""
+    os.makedirs(os.path.join(BUILD, "generated"), exist_ok=True)
+    # Divisions are by powers of two, so the sums stay exact and print the
+    # same in both implementations.
+    programs = {
+        "large_arithmetic": lambda rng: balanced(
+            rng, 17,
+            lambda r: "{} * {} / {}".format(r.randint(1, 9), r.randint(1, 9),
+                                            r.choice([1, 2, 4, 8])),
+            ["+", "-"]),
+        "large_strings": lambda rng: balanced(
+            rng, 13, lambda r: '"{}"'.format(r.choice("abcdefgh") * 3),
+            ["+"]),
+    }
+    paths = []
+    for name, program in programs.items():
+        path = os.path.join(BUILD, "generated", name + ".lox")
+        if not os.path.exists(path):
+            with open(path, "w", encoding="utf-8") as file:
+                file.write(program(random.Random(name)) + "\n")
+        paths.append(path)
+    return paths
+
+
+def clox_program(path):
+    """The expression of `path` as a clox program. The semicolon goes on its
+    own line, so that a comment at the end doesn't swallow it."""
+    os.makedirs(os.path.join(BUILD, "clox_programs"), exist_ok=True)
+    wrapped = os.path.join(BUILD, "clox_programs", os.path.basename(path))
+    with open(path, encoding="utf-8") as source:
+        expression = source.read()
+    with open(wrapped, "w", encoding="utf-8") as file:
+        file.write("print " + expression + "\n;\n")
+    return wrapped
+
+
+def perf_works():
+    if shutil.which("perf") is None:
+        return False
+    result = subprocess.run(
+        ["perf", "stat", "-x,", "-e", "instructions:u", "true"],
+        stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+    return result.returncode == 0 and "<not" not in result.stderr
+
+
+def run_once(measure, command, use_perf):
+    """Runs `command` and returns its output, wall time, instructions (or
+    None) and peak RSS in KiB."""
+    with tempfile.TemporaryDirectory() as directory:
+        result_path = os.path.join(directory, "result")
+        perf_path = os.path.join(directory, "perf")
+        command = [measure, result_path] + command
+        if use_perf:
+            command = ["perf", "stat", "-x,", "-e", "instructions:u", "-o",
+                       perf_path, "--"] + command
+        process = subprocess.run(command, capture_output=True)
+        with open(result_path, encoding="utf-8") as file:
+            exit_code, wall, max_rss = file.read().split()
+        instructions = None
+        if use_perf:
+            with open(perf_path, encoding="utf-8") as file:
+                for line in file:
+                    fields = line.split(",")
+                    if (len(fields) > 2 and
+                            fields[2].startswith("instructions") and
+                            fields[0].isdigit()):
+                        instructions = int(fields[0])
+    if int(exit_code) != 0:
+        raise RuntimeError("{} exited with {}:\n{}".format(
+            " ".join(command), exit_code,
+            process.stderr.decode("utf-8", "replace")))
+    return (process.stdout.decode("utf-8", "replace"), float(wall),
+            instructions, int(max_rss))
+
+
+def measure(measure_binary, command, runs, use_perf):
+    outputs, walls, instructions, rss = [], [], [], []
+    for _ in range(runs):
+        output, wall, count, max_rss = run_once(measure_binary, command,
+                                                use_perf)
+        outputs.append(output)
+        walls.append(wall)
+        if count is not None:
+            instructions.append(count)
+        rss.append(max_rss)
+    return {
+        "output": outputs[0],
+        "wall_seconds": statistics.median(walls),
+        "instructions": (int(statistics.median(instructions))
+                         if instructions else None),
+        "max_rss_kb": max(rss),
+    }
+
+
+def commit():
+    def git(*args):
+        return subprocess.run(["git", "-C", ROOT] + list(args),
+                              capture_output=True, text=True).stdout.strip()
+    revision = git("rev-parse", "--short", "HEAD") or "unknown"
+    if git("status", "--porcelain", "--untracked-files=no"):
+        revision += "-dirty"
+    return revision
+
+
+def append_history(records):
+    os.makedirs(RESULTS, exist_ok=True)
+    csv_path = os.path.join(RESULTS, "history.csv")
+    is_new = not os.path.exists(csv_path)
+    with open(csv_path, "a", newline="", encoding="utf-8") as file:
+        writer = csv.DictWriter(file, fieldnames=FIELDS)
+        if is_new:
+            writer.writeheader()
+        writer.writerows(records)
+    with open(os.path.join(RESULTS, "history.jsonl"), "a",
+              encoding="utf-8") as file:
+        for record in records:
+            file.write(json.dumps(record) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--filter", default="",
+                        help="only run the benchmarks whose name contains it")
+    parser.add_argument("--jlox", help="jlox binary to use instead of building")
+    parser.add_argument("--clox", help="clox binary to use instead of building")
+    args = parser.parse_args()
+
+    os.makedirs(BUILD, exist_ok=True)
+    implementations = {
+        "jlox": args.jlox or build_jlox(),
+        "clox": args.clox or build_clox(),
+    }
+    measure_binary = build_measure()
+    use_perf = perf_works()
+    if not use_perf:
+        print("perf isn't usable here, instructions aren't recorded.",
+              file=sys.stderr)
+
+    programs = sorted(glob.glob(os.path.join(BENCHMARKS, "corpus", "*.lox")))
+    programs += generate()
+    timestamp = datetime.datetime.now(datetime.timezone.utc).isoformat(
+        timespec="seconds")
+    revision = commit()
+    records = []
+    failed = False
+    print("{:<20} {:<6} {:>10} {:>14} {:>10}  {}".format(
+        "benchmark", "impl", "wall ms", "instructions", "rss KiB", "match"))
+    for path in programs:
+        name = os.path.splitext(os.path.basename(path))[0]
+        if args.filter not in name:
+            continue
+        inputs = {"jlox": path, "clox": clox_program(path)}
+        results = {}
+        for implementation, binary in implementations.items():
+            try:
+                results[implementation] = measure(
+                    measure_binary, [binary, inputs[implementation]],
+                    args.runs, use_perf)
+            except RuntimeError as error:
+                print(error, file=sys.stderr)
+                failed = True
+        match = (len(results) == len(implementations) and
+                 results["jlox"]["output"] == results["clox"]["output"])
+        failed = failed or not match
+        for implementation, result in results.items():
+            record = {
+                "timestamp": timestamp,
+                "commit": revision,
+                "benchmark": name,
+                "implementation": implementation,
+                "bytes": os.path.getsize(path),
+                "runs": args.runs,
+                "wall_seconds": round(result["wall_seconds"], 6),
+                "instructions": result["instructions"],
+                "max_rss_kb": result["max_rss_kb"],
+                "outputs_match": match,
+            }
+            records.append(record)
+            print("{:<20} {:<6} {:>10.2f} {:>14} {:>10}  {}".format(
+                name, implementation, record["wall_seconds"] * 1000,
+                record["instructions"] or "-", record["max_rss_kb"],
+                "yes" if match else "NO"))
+
+    append_history(records)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
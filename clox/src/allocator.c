@@ -0,0 +1,252 @@
+#define _DEFAULT_SOURCE
+
+#include "allocator.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "memory.h" // memory_*
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#define POISON(address, size) ASAN_POISON_MEMORY_REGION(address, size)
+#define UNPOISON(address, size) ASAN_UNPOISON_MEMORY_REGION(address, size)
+#else
+#define POISON(address, size) ((void)(address), (void)(size))
+#define UNPOISON(address, size) ((void)(address), (void)(size))
+#endif
+
+typedef struct FreeBlock {
+    struct FreeBlock* next;
+} FreeBlock;
+
+// Lives at the start of its slab, the blocks follow it.
+struct Slab {
+    Slab* previous;
+    Slab* next;
+    // Blocks that were handed out and freed again.
+    FreeBlock* free_list;
+    // Blocks past this point were never handed out. Carving lazily keeps
+    // untouched pages of a fresh slab from being faulted in.
+    uint8_t* bump;
+    uint8_t* end;
+    size_t block_size;
+    size_t live;
+};
+
+#define SLAB_HEADER_SIZE                                                       \
+    ((sizeof(Slab) + CLOX_ALLOCATOR_GRANULE - 1) /                             \
+     CLOX_ALLOCATOR_GRANULE * CLOX_ALLOCATOR_GRANULE)
+
+static size_t class_index(size_t const size) {
+    assert(size > 0 && size <= CLOX_ALLOCATOR_MAX_SMALL);
+    return (size + CLOX_ALLOCATOR_GRANULE - 1) / CLOX_ALLOCATOR_GRANULE - 1;
+}
+
+static bool is_small(size_t const size) {
+    return size <= CLOX_ALLOCATOR_MAX_SMALL;
+}
+
+static Slab* slab_of(void* block) {
+    return (Slab*)((uintptr_t)block &
+                   ~(uintptr_t)(CLOX_ALLOCATOR_SLAB_SIZE - 1));
+}
+
+static void list_remove(Slab** pList, Slab* slab) {
+    if (slab->previous != NULL) {
+        slab->previous->next = slab->next;
+    } else {
+        *pList = slab->next;
+    }
+    if (slab->next != NULL) {
+        slab->next->previous = slab->previous;
+    }
+    slab->previous = NULL;
+    slab->next = NULL;
+}
+
+static void list_push(Slab** pList, Slab* slab) {
+    slab->previous = NULL;
+    slab->next = *pList;
+    if (*pList != NULL) {
+        (*pList)->previous = slab;
+    }
+    *pList = slab;
+}
+
+static bool slab_is_full(Slab const* slab) {
+    return slab->free_list == NULL && slab->bump == slab->end;
+}
+
+// Slabs are mapped straight from the OS so that releasing one really gives
+// its pages back. Twice the size is mapped and trimmed to get the alignment.
+static Slab* map_slab(Allocator* pAllocator, size_t const block_size) {
+    size_t const size = CLOX_ALLOCATOR_SLAB_SIZE;
+    uint8_t* region = mmap(NULL, size * 2, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(region != MAP_FAILED);
+    uintptr_t const aligned =
+        ((uintptr_t)region + size - 1) & ~(uintptr_t)(size - 1);
+    size_t const head = aligned - (uintptr_t)region;
+    if (head > 0) {
+        munmap(region, head);
+    }
+    if (size - head > 0) {
+        munmap((uint8_t*)aligned + size, size - head);
+    }
+
+    Slab* slab = (Slab*)aligned;
+    uint8_t* blocks = (uint8_t*)slab + SLAB_HEADER_SIZE;
+    size_t const block_count = (size - SLAB_HEADER_SIZE) / block_size;
+    *slab = (Slab){.previous = NULL,
+                   .next = NULL,
+                   .free_list = NULL,
+                   .bump = blocks,
+                   .end = blocks + block_count * block_size,
+                   .block_size = block_size,
+                   .live = 0};
+    POISON(blocks, size - SLAB_HEADER_SIZE);
+    memory_track(MEMORY_heap, 0, size);
+    pAllocator->stats.slabs_live += 1;
+    pAllocator->stats.slabs_allocated += 1;
+    return slab;
+}
+
+static void unmap_slab(Allocator* pAllocator, Slab* slab) {
+    UNPOISON(slab, CLOX_ALLOCATOR_SLAB_SIZE);
+    munmap(slab, CLOX_ALLOCATOR_SLAB_SIZE);
+    memory_track(MEMORY_heap, CLOX_ALLOCATOR_SLAB_SIZE, 0);
+    pAllocator->stats.slabs_live -= 1;
+    pAllocator->stats.slabs_released += 1;
+}
+
+static void* allocate_small(Allocator* pAllocator, size_t const size) {
+    size_t const index = class_index(size);
+    SizeClass* size_class = &pAllocator->classes[index];
+    Slab* slab = size_class->available;
+    if (slab == NULL) {
+        slab = map_slab(pAllocator, (index + 1) * CLOX_ALLOCATOR_GRANULE);
+        list_push(&size_class->available, slab);
+    }
+
+    void* block;
+    if (slab->free_list != NULL) {
+        block = slab->free_list;
+        UNPOISON(block, slab->block_size);
+        slab->free_list = slab->free_list->next;
+    } else {
+        block = slab->bump;
+        UNPOISON(block, slab->block_size);
+        slab->bump += slab->block_size;
+    }
+    slab->live += 1;
+    if (slab_is_full(slab)) {
+        list_remove(&size_class->available, slab);
+        list_push(&size_class->full, slab);
+    }
+    pAllocator->stats.small_allocations += 1;
+    return block;
+}
+
+static void free_small(Allocator* pAllocator, void* block) {
+    Slab* slab = slab_of(block);
+    SizeClass* size_class =
+        &pAllocator->classes[slab->block_size / CLOX_ALLOCATOR_GRANULE - 1];
+    if (slab_is_full(slab)) {
+        list_remove(&size_class->full, slab);
+        list_push(&size_class->available, slab);
+    }
+
+    FreeBlock* free_block = block;
+    free_block->next = slab->free_list;
+    slab->free_list = free_block;
+    POISON(block, slab->block_size);
+    slab->live -= 1;
+
+    // An empty slab goes back to the OS, unless it's the only one left with
+    // room in its class: keeping it avoids remapping on every alloc/free
+    // pair at a slab boundary.
+    if (slab->live == 0 &&
+        (slab->previous != NULL || slab->next != NULL)) {
+        list_remove(&size_class->available, slab);
+        unmap_slab(pAllocator, slab);
+    }
+}
+
+Allocator allocator_new(void) {
+    Allocator allocator;
+    for (size_t i = 0; i < CLOX_ALLOCATOR_CLASS_COUNT; i++) {
+        allocator.classes[i] = (SizeClass){.available = NULL, .full = NULL};
+    }
+    allocator.stats = (AllocatorStats){0};
+    return allocator;
+}
+
+void allocator_free(Allocator* pAllocator) {
+    assert(pAllocator != NULL);
+    for (size_t i = 0; i < CLOX_ALLOCATOR_CLASS_COUNT; i++) {
+        SizeClass* size_class = &pAllocator->classes[i];
+        while (size_class->available != NULL) {
+            Slab* slab = size_class->available;
+            list_remove(&size_class->available, slab);
+            unmap_slab(pAllocator, slab);
+        }
+        while (size_class->full != NULL) {
+            Slab* slab = size_class->full;
+            list_remove(&size_class->full, slab);
+            unmap_slab(pAllocator, slab);
+        }
+    }
+}
+
+void* allocator_reallocate(Allocator* pAllocator, void* pointer,
+                           size_t const old_size, size_t const new_size) {
+    assert(pAllocator != NULL);
+    assert((pointer == NULL) == (old_size == 0));
+    if (new_size == 0) {
+        if (pointer == NULL) {
+            return NULL;
+        }
+        if (is_small(old_size)) {
+            free_small(pAllocator, pointer);
+        } else {
+            memory_reallocate(MEMORY_heap, pointer, old_size, 0);
+        }
+        return NULL;
+    }
+
+    if (!is_small(new_size)) {
+        pAllocator->stats.large_allocations += 1;
+        if (pointer == NULL || !is_small(old_size)) {
+            return memory_reallocate(MEMORY_heap, pointer, old_size, new_size);
+        }
+        void* result = memory_reallocate(MEMORY_heap, NULL, 0, new_size);
+        memcpy(result, pointer, old_size);
+        free_small(pAllocator, pointer);
+        return result;
+    }
+
+    if (pointer != NULL && is_small(old_size) &&
+        class_index(old_size) == class_index(new_size)) {
+        return pointer;
+    }
+    void* result = allocate_small(pAllocator, new_size);
+    if (pointer != NULL) {
+        memcpy(result, pointer, old_size < new_size ? old_size : new_size);
+        if (is_small(old_size)) {
+            free_small(pAllocator, pointer);
+        } else {
+            memory_reallocate(MEMORY_heap, pointer, old_size, 0);
+        }
+    }
+    return result;
+}
+
+AllocatorStats allocator_stats(Allocator const* pAllocator) {
+    assert(pAllocator != NULL);
+    return pAllocator->stats;
+}
@@ -0,0 +1,50 @@
+#ifndef CLOX_ALLOCATOR_H
+#define CLOX_ALLOCATOR_H
+
+#include <stddef.h>
+
+// Slabs are aligned to their size, so the slab owning a block is found by
+// masking the block address.
+#define CLOX_ALLOCATOR_SLAB_SIZE (64 * 1024)
+// Small sizes are rounded up to a multiple of the granule.
+#define CLOX_ALLOCATOR_GRANULE 16
+// Requests above this size bypass the slabs and go to malloc.
+#define CLOX_ALLOCATOR_MAX_SMALL 256
+#define CLOX_ALLOCATOR_CLASS_COUNT                                             \
+    (CLOX_ALLOCATOR_MAX_SMALL / CLOX_ALLOCATOR_GRANULE)
+
+typedef struct Slab Slab;
+
+typedef struct {
+    // Slabs that still have at least one free block, allocation takes from
+    // the head of this list.
+    Slab* available;
+    Slab* full;
+} SizeClass;
+
+typedef struct {
+    size_t slabs_live;
+    size_t slabs_allocated;
+    size_t slabs_released;
+    size_t small_allocations;
+    size_t large_allocations;
+} AllocatorStats;
+
+typedef struct {
+    SizeClass classes[CLOX_ALLOCATOR_CLASS_COUNT];
+    AllocatorStats stats;
+} Allocator;
+
+Allocator allocator_new(void);
+
+// Releases every slab, whether or not its blocks were freed.
+void allocator_free(Allocator* pAllocator);
+
+// realloc() with the caller keeping track of sizes, like gc_reallocate().
+// `new_size == 0` frees the block.
+void* allocator_reallocate(Allocator* pAllocator, void* pointer,
+                           size_t const old_size, size_t const new_size);
+
+AllocatorStats allocator_stats(Allocator const* pAllocator);
+
+#endif // !CLOX_ALLOCATOR_H
@@ -0,0 +1,174 @@
+#include "batch.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h" // Chunk, OPCODE_*
+#include "value.h" // Value, VALUE_*
+
+static uint16_t read_short(uint8_t const* code) {
+    return (uint16_t)((code[0] << 8) | code[1]);
+}
+
+bool batch_can_run(Chunk const* pChunk, double const* const* columns,
+                   size_t const column_count) {
+    assert(pChunk != NULL);
+    int depth = 0;
+    for (size_t offset = 0; offset < pChunk->count;) {
+        switch (pChunk->code[offset]) {
+        case OPCODE_constant: {
+            Value const constant =
+                pChunk->constants.values[pChunk->code[offset + 1]];
+            if (!VALUE_IS_NUMBER(constant)) {
+                return false;
+            }
+            depth += 1;
+            offset += 2;
+            break;
+        }
+        case OPCODE_get_global: {
+            uint16_t const slot = read_short(&pChunk->code[offset + 1]);
+            if (slot >= column_count || columns[slot] == NULL) {
+                return false;
+            }
+            depth += 1;
+            offset += 3;
+            break;
+        }
+        case OPCODE_add:
+        case OPCODE_add_num_num:
+        case OPCODE_subtract:
+        case OPCODE_multiply:
+        case OPCODE_divide:
+            depth -= 1;
+            offset += 1;
+            break;
+        case OPCODE_negate:
+            offset += 1;
+            break;
+        case OPCODE_return:
+            return depth == 1;
+        default:
+            return false;
+        }
+        if (depth > CLOX_BATCH_STACK_MAX) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Every loop below is a straight pass over the lanes that the compiler
+// vectorizes, which is where the time goes rather than dispatch.
+
+static void fill(double* out, double const value, size_t const count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = value;
+    }
+}
+
+#define BINARY_LOOP(op)                                                        \
+    for (size_t i = 0; i < count; i++) {                                       \
+        out[i] = a[i] op b[i];                                                 \
+    }
+
+static void run_tile(Chunk const* pChunk, double const* const* columns,
+                     size_t const first, size_t const count, double* results) {
+    // The stack holds lanes rather than values. A global's entry points
+    // straight into its column, everything else is computed into the
+    // scratch tile of the stack slot.
+    double scratch[CLOX_BATCH_STACK_MAX][CLOX_BATCH_TILE];
+    double const* stack[CLOX_BATCH_STACK_MAX];
+    int top = 0;
+
+    uint8_t const* ip = pChunk->code;
+    for (;;) {
+        switch (*ip++) {
+        case OPCODE_constant: {
+            double const value =
+                VALUE_AS_NUMBER(pChunk->constants.values[*ip++]);
+            fill(scratch[top], value, count);
+            stack[top] = scratch[top];
+            top += 1;
+            break;
+        }
+        case OPCODE_get_global:
+            stack[top] = columns[read_short(ip)] + first;
+            ip += 2;
+            top += 1;
+            break;
+        case OPCODE_add:
+        case OPCODE_add_num_num: {
+            double const* a = stack[top - 2];
+            double const* b = stack[top - 1];
+            double* out = scratch[top - 2];
+            BINARY_LOOP(+);
+            stack[top - 2] = out;
+            top -= 1;
+            break;
+        }
+        case OPCODE_subtract: {
+            double const* a = stack[top - 2];
+            double const* b = stack[top - 1];
+            double* out = scratch[top - 2];
+            BINARY_LOOP(-);
+            stack[top - 2] = out;
+            top -= 1;
+            break;
+        }
+        case OPCODE_multiply: {
+            double const* a = stack[top - 2];
+            double const* b = stack[top - 1];
+            double* out = scratch[top - 2];
+            BINARY_LOOP(*);
+            stack[top - 2] = out;
+            top -= 1;
+            break;
+        }
+        case OPCODE_divide: {
+            double const* a = stack[top - 2];
+            double const* b = stack[top - 1];
+            double* out = scratch[top - 2];
+            BINARY_LOOP(/);
+            stack[top - 2] = out;
+            top -= 1;
+            break;
+        }
+        case OPCODE_negate: {
+            double const* a = stack[top - 1];
+            double* out = scratch[top - 1];
+            for (size_t i = 0; i < count; i++) {
+                out[i] = -a[i];
+            }
+            stack[top - 1] = out;
+            break;
+        }
+        case OPCODE_return: {
+            double const* a = stack[top - 1];
+            double* out = results + first;
+            for (size_t i = 0; i < count; i++) {
+                out[i] = a[i];
+            }
+            return;
+        }
+        default:
+            assert(false && "batch_can_run() let an opcode through");
+            return;
+        }
+    }
+}
+
+#undef BINARY_LOOP
+
+void batch_run(Chunk const* pChunk, double const* const* columns,
+               size_t const rows, double* results) {
+    assert(pChunk != NULL);
+    assert(results != NULL);
+    for (size_t first = 0; first < rows; first += CLOX_BATCH_TILE) {
+        size_t const count =
+            rows - first < CLOX_BATCH_TILE ? rows - first : CLOX_BATCH_TILE;
+        run_tile(pChunk, columns, first, count, results);
+    }
+}
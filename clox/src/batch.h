@@ -0,0 +1,31 @@
+#ifndef CLOX_BATCH_H
+#define CLOX_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "chunk.h" // Chunk
+
+// Rows are evaluated a tile at a time, every instruction of the chunk is
+// dispatched once per tile and runs a loop over its lanes.
+#define CLOX_BATCH_TILE 256
+#define CLOX_BATCH_STACK_MAX 16
+
+// Input of a batch, the values of the global `name` for each row.
+typedef struct {
+    char const* name;
+    double const* values;
+} BatchColumn;
+
+// Whether `pChunk` is an expression over numbers only, which batch_run()
+// can evaluate: number constants, globals bound to a column and arithmetic.
+// `columns` is indexed by global slot, NULL marks an unbound global.
+bool batch_can_run(Chunk const* pChunk, double const* const* columns,
+                   size_t const column_count);
+
+// Evaluates the expression in `pChunk` once per row, reading each global
+// from its column and writing the value to `results[row]`.
+void batch_run(Chunk const* pChunk, double const* const* columns,
+               size_t const rows, double* results);
+
+#endif // !CLOX_BATCH_H
@@ -0,0 +1,97 @@
+#include "cache.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "chunk.h"  // Chunk, chunk_*
+#include "memory.h" // memory_*
+
+// FNV-1a.
+static uint64_t hash_source(char const* source, size_t const length) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)source[i];
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+static void clear_entry(ChunkCacheEntry* pEntry) {
+    chunk_free(&pEntry->chunk);
+    memory_reallocate(MEMORY_source, pEntry->source, pEntry->length + 1, 0);
+    *pEntry = (ChunkCacheEntry){0};
+}
+
+ChunkCache chunk_cache_new(void) {
+    ChunkCache cache;
+    for (size_t i = 0; i < CLOX_CHUNK_CACHE_CAPACITY; i++) {
+        cache.entries[i] = (ChunkCacheEntry){0};
+    }
+    cache.clock = 0;
+    cache.stats = (ChunkCacheStats){0};
+    return cache;
+}
+
+void chunk_cache_free(ChunkCache* pCache) {
+    assert(pCache != NULL);
+    for (size_t i = 0; i < CLOX_CHUNK_CACHE_CAPACITY; i++) {
+        if (pCache->entries[i].last_used != 0) {
+            clear_entry(&pCache->entries[i]);
+        }
+    }
+}
+
+// The cache is small enough that scanning the hashes costs next to nothing
+// next to compiling.
+Chunk* chunk_cache_find(ChunkCache* pCache, char const* source,
+                        size_t const length) {
+    assert(pCache != NULL);
+    uint64_t const hash = hash_source(source, length);
+    for (size_t i = 0; i < CLOX_CHUNK_CACHE_CAPACITY; i++) {
+        ChunkCacheEntry* entry = &pCache->entries[i];
+        if (entry->last_used != 0 && entry->hash == hash &&
+            entry->length == length &&
+            memcmp(entry->source, source, length) == 0) {
+            pCache->clock += 1;
+            entry->last_used = pCache->clock;
+            pCache->stats.hits += 1;
+            return &entry->chunk;
+        }
+    }
+    pCache->stats.misses += 1;
+    return NULL;
+}
+
+Chunk* chunk_cache_insert(ChunkCache* pCache, char const* source,
+                          size_t const length, Chunk const chunk) {
+    assert(pCache != NULL);
+    ChunkCacheEntry* victim = &pCache->entries[0];
+    for (size_t i = 0; i < CLOX_CHUNK_CACHE_CAPACITY; i++) {
+        ChunkCacheEntry* entry = &pCache->entries[i];
+        if (entry->last_used < victim->last_used) {
+            victim = entry;
+        }
+    }
+    if (victim->last_used != 0) {
+        clear_entry(victim);
+        pCache->stats.evictions += 1;
+    }
+
+    char* copy = memory_reallocate(MEMORY_source, NULL, 0, length + 1);
+    memcpy(copy, source, length);
+    copy[length] = '\0';
+    pCache->clock += 1;
+    *victim = (ChunkCacheEntry){.hash = hash_source(source, length),
+                                .source = copy,
+                                .length = length,
+                                .chunk = chunk,
+                                .last_used = pCache->clock};
+    return &victim->chunk;
+}
+
+ChunkCacheStats chunk_cache_stats(ChunkCache const* pCache) {
+    assert(pCache != NULL);
+    return pCache->stats;
+}
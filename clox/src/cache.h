@@ -0,0 +1,50 @@
+#ifndef CLOX_CACHE_H
+#define CLOX_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h" // Chunk
+
+#define CLOX_CHUNK_CACHE_CAPACITY 64
+
+typedef struct {
+    uint64_t hash;
+    char* source;
+    size_t length;
+    Chunk chunk;
+    // Tick of the last lookup that hit or inserted the entry, 0 when the
+    // entry is empty.
+    uint64_t last_used;
+} ChunkCacheEntry;
+
+typedef struct {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+} ChunkCacheStats;
+
+// Compiled chunks by source text, the least recently used one is evicted
+// when it's full. Chunks stay bound to the globals of the VM that compiled
+// them, so a cache must not be shared between VMs.
+typedef struct {
+    ChunkCacheEntry entries[CLOX_CHUNK_CACHE_CAPACITY];
+    uint64_t clock;
+    ChunkCacheStats stats;
+} ChunkCache;
+
+ChunkCache chunk_cache_new(void);
+
+void chunk_cache_free(ChunkCache* pCache);
+
+// Returns the chunk compiled from `source`, or NULL.
+Chunk* chunk_cache_find(ChunkCache* pCache, char const* source,
+                        size_t const length);
+
+// Takes ownership of `chunk` and returns where it's kept now.
+Chunk* chunk_cache_insert(ChunkCache* pCache, char const* source,
+                          size_t const length, Chunk const chunk);
+
+ChunkCacheStats chunk_cache_stats(ChunkCache const* pCache);
+
+#endif // !CLOX_CACHE_H
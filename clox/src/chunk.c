@@ -1,45 +1,69 @@
 #include "chunk.h"
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <stdlib.h>
+#include <string.h>
 
-#include "line.h"  // LineVector, LineInfo, line_*
-#include "value.h" // Value, ValueVector, value_*
+#include "line.h"   // LineVector, LineInfo, line_*
+#include "memory.h" // memory_*
+#include "shape.h"  // ShapeCache
+#include "value.h"  // Value, ValueVector, value_*
 
 Chunk chunk_new_alloc(void) {
-    uint8_t* code = malloc(sizeof(*code) * CLOX_CHUNK_MIN_CAPACITY);
-    assert(code != NULL);
+    uint8_t* code = memory_reallocate(MEMORY_code, NULL, 0,
+                                      sizeof(*code) * CLOX_CHUNK_MIN_CAPACITY);
     ValueVector constants = value_vector_new_alloc();
     LineVector lines = line_vector_new_alloc();
     return (Chunk){.code = code,
                    .capacity = CLOX_CHUNK_MIN_CAPACITY,
                    .count = 0,
                    .constants = constants,
-                   .line_vector = lines};
+                   .line_vector = lines,
+                   .shape_caches = NULL,
+                   .shape_cache_count = 0,
+                   .shape_cache_capacity = 0,
+                   .stack_size = 0,
+                   .frozen = NULL,
+                   .frozen_size = 0};
 }
 
 void chunk_free(Chunk* pChunk) {
     assert(pChunk != NULL);
     assert(pChunk->code != NULL);
-    free(pChunk->code);
-    pChunk->code = NULL;
-    value_vector_free(&(pChunk->constants));
+    if (pChunk->frozen != NULL) {
+        pChunk->frozen = memory_reallocate(MEMORY_code, pChunk->frozen,
+                                           pChunk->frozen_size, 0);
+        pChunk->code = NULL;
+        pChunk->constants.values = NULL;
+        pChunk->shape_caches = NULL;
+    } else {
+        pChunk->code =
+            memory_reallocate(MEMORY_code, pChunk->code,
+                              sizeof(*pChunk->code) * pChunk->capacity, 0);
+        value_vector_free(&(pChunk->constants));
+        pChunk->shape_caches = memory_reallocate(
+            MEMORY_code, pChunk->shape_caches,
+            sizeof(*pChunk->shape_caches) * pChunk->shape_cache_capacity, 0);
+    }
     line_vector_free(&(pChunk->line_vector));
 }
 
 void chunk_push(Chunk* pChunk, uint8_t const byte, int const line) {
     assert(pChunk != NULL);
     assert(pChunk->code != NULL);
+    assert(pChunk->frozen == NULL);
     // Chunk full, needs to reallocate
     if (pChunk->count >= pChunk->capacity) {
         size_t new_capacity = (pChunk->capacity < CLOX_CHUNK_MIN_CAPACITY
                                    ? CLOX_CHUNK_MIN_CAPACITY
                                    : pChunk->capacity * 2);
         pChunk->code =
-            realloc(pChunk->code, sizeof(*pChunk->code) * new_capacity);
-        assert(pChunk->code != NULL);
+            memory_reallocate(MEMORY_code, pChunk->code,
+                              sizeof(*pChunk->code) * pChunk->capacity,
+                              sizeof(*pChunk->code) * new_capacity);
+        pChunk->capacity = new_capacity;
     }
     pChunk->code[pChunk->count] = byte;
     pChunk->count += 1;
@@ -54,9 +78,311 @@ void chunk_push(Chunk* pChunk, uint8_t const byte, int const line) {
     pChunk->line_vector = line_vector_push(pChunk->line_vector, line_info);
 }
 
+void chunk_truncate(Chunk* pChunk, size_t const count) {
+    assert(pChunk != NULL);
+    assert(count <= pChunk->count);
+    assert(pChunk->frozen == NULL);
+    pChunk->count = count;
+    while (pChunk->line_vector.count > 0 &&
+           pChunk->line_vector.lines[pChunk->line_vector.count - 1].offset >=
+               count) {
+        pChunk->line_vector.count -= 1;
+    }
+}
+
 size_t chunk_add_constant(Chunk* pChunk, Value const value) {
     assert(pChunk != NULL);
+    assert(pChunk->frozen == NULL);
     ValueVector new_constants = value_vector_push(pChunk->constants, value);
     pChunk->constants = new_constants;
     return pChunk->constants.count - 1;
 }
+
+size_t chunk_add_shape_cache(Chunk* pChunk) {
+    assert(pChunk != NULL);
+    assert(pChunk->frozen == NULL);
+    if (pChunk->shape_cache_count >= pChunk->shape_cache_capacity) {
+        size_t const capacity =
+            (pChunk->shape_cache_capacity < CLOX_CHUNK_MIN_CAPACITY
+                 ? CLOX_CHUNK_MIN_CAPACITY
+                 : pChunk->shape_cache_capacity * 2);
+        pChunk->shape_caches = memory_reallocate(
+            MEMORY_code, pChunk->shape_caches,
+            sizeof(*pChunk->shape_caches) * pChunk->shape_cache_capacity,
+            sizeof(*pChunk->shape_caches) * capacity);
+        pChunk->shape_cache_capacity = capacity;
+    }
+    pChunk->shape_caches[pChunk->shape_cache_count] = (ShapeCache){0};
+    pChunk->shape_cache_count += 1;
+    return pChunk->shape_cache_count - 1;
+}
+
+// What an instruction does to the stack, and its length.
+typedef struct {
+    size_t pushes;
+    size_t pops;
+    size_t length;
+} Effect;
+
+// Conditional jumps are counted as falling through.
+static Effect effect(uint8_t const* code) {
+    Effect effect = {.pushes = 0, .pops = 0, .length = 1};
+    switch ((enum OPCODE)code[0]) {
+    case OPCODE_nil:
+    case OPCODE_true:
+    case OPCODE_false:
+    case OPCODE_get_local_0:
+    case OPCODE_get_local_1:
+    case OPCODE_get_local_2:
+    case OPCODE_get_local_3:
+        effect.pushes = 1;
+        break;
+    case OPCODE_constant:
+    case OPCODE_get_local:
+    case OPCODE_class:
+        effect.pushes = 1;
+        effect.length = 2;
+        break;
+    case OPCODE_get_global:
+    case OPCODE_import:
+        effect.pushes = 1;
+        effect.length = 3;
+        break;
+    case OPCODE_pop:
+    case OPCODE_equal:
+    case OPCODE_greater:
+    case OPCODE_less:
+    case OPCODE_add:
+    case OPCODE_subtract:
+    case OPCODE_multiply:
+    case OPCODE_divide:
+    case OPCODE_add_num_num:
+    case OPCODE_add_str_str:
+    case OPCODE_print:
+    case OPCODE_return:
+        effect.pops = 1;
+        break;
+    case OPCODE_define_global:
+    case OPCODE_jump_if_false:
+    case OPCODE_jump_if_false_or_pop:
+    case OPCODE_jump_if_true_or_pop:
+        effect.pops = 1;
+        effect.length = 3;
+        break;
+    case OPCODE_jump_if_equal:
+    case OPCODE_jump_if_not_equal:
+    case OPCODE_jump_if_greater:
+    case OPCODE_jump_if_not_greater:
+    case OPCODE_jump_if_less:
+    case OPCODE_jump_if_not_less:
+        effect.pops = 2;
+        effect.length = 3;
+        break;
+    case OPCODE_set_global:
+    case OPCODE_jump:
+    case OPCODE_loop:
+        effect.length = 3;
+        break;
+    case OPCODE_set_local:
+    case OPCODE_subtract_local:
+    case OPCODE_multiply_local:
+    case OPCODE_divide_local:
+        effect.length = 2;
+        break;
+    case OPCODE_add_local:
+    case OPCODE_add_local_num_num:
+    case OPCODE_add_local_str_str:
+        // Concatenating pushes the local before replacing both.
+        effect.pushes = 1;
+        effect.pops = 1;
+        effect.length = 2;
+        break;
+    case OPCODE_negate:
+    case OPCODE_not:
+        break;
+    case OPCODE_call:
+    case OPCODE_tail_call:
+        // The arguments are replaced, the callee's slot gets the result.
+        effect.pops = code[1];
+        effect.length = 2;
+        break;
+    case OPCODE_get_property:
+        effect.length = 4;
+        break;
+    case OPCODE_set_property:
+        effect.pops = 1;
+        effect.length = 4;
+        break;
+    }
+    return effect;
+}
+
+// Walks the code once, tracking the stack depth. The compiler leaves the
+// depth the same on every path to an instruction, and the code after an
+// unconditional jump starts at the depth the jump left, so it's exact.
+static size_t stack_size(Chunk const* pChunk) {
+    size_t depth = 0;
+    size_t max = 0;
+    for (size_t offset = 0; offset < pChunk->count;) {
+        Effect const instruction = effect(&pChunk->code[offset]);
+        depth += instruction.pushes;
+        if (depth > max) {
+            max = depth;
+        }
+        // Code with compile errors may not balance, but it never runs.
+        depth = depth > instruction.pops ? depth - instruction.pops : 0;
+        offset += instruction.length;
+    }
+    return max;
+}
+
+static bool is_jump(uint8_t const opcode) {
+    switch ((enum OPCODE)opcode) {
+    case OPCODE_jump:
+    case OPCODE_loop:
+    case OPCODE_jump_if_false:
+    case OPCODE_jump_if_false_or_pop:
+    case OPCODE_jump_if_true_or_pop:
+    case OPCODE_jump_if_equal:
+    case OPCODE_jump_if_not_equal:
+    case OPCODE_jump_if_greater:
+    case OPCODE_jump_if_not_greater:
+    case OPCODE_jump_if_less:
+    case OPCODE_jump_if_not_less:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static size_t jump_target(uint8_t const* code, size_t const offset) {
+    size_t const distance = (size_t)(code[offset + 1] << 8 | code[offset + 2]);
+    return code[offset] == OPCODE_loop ? offset + 3 - distance
+                                       : offset + 3 + distance;
+}
+
+// Whether a jump that's taken always takes the jump it lands on as well. A
+// jump keeping its operand lands on the same jump when `and`s or `or`s are
+// chained, which sees the same operand.
+static bool takes(uint8_t const jump, uint8_t const next) {
+    if (next == OPCODE_jump || next == OPCODE_loop) {
+        return true;
+    }
+    return next == jump && (jump == OPCODE_jump_if_false_or_pop ||
+                            jump == OPCODE_jump_if_true_or_pop);
+}
+
+// Points every jump at the end of the chain of jumps it starts, which the
+// compiler leaves behind around nested `if`s and loops. Conditional jumps
+// only go forwards, so they only skip the jumps that do too, and only loops
+// go backwards, so every cycle still meets one.
+static void thread_jumps(Chunk* pChunk) {
+    uint8_t* code = pChunk->code;
+    for (size_t offset = 0; offset < pChunk->count;
+         offset += effect(&code[offset]).length) {
+        uint8_t const jump = code[offset];
+        if (!is_jump(jump)) {
+            continue;
+        }
+        size_t target = jump_target(code, offset);
+        // A chain longer than the code goes round in circles, like an
+        // empty `for (;;)` does.
+        for (size_t hops = 0; hops < pChunk->count && target < pChunk->count &&
+                              takes(jump, code[target]);
+             hops++) {
+            target = jump_target(code, target);
+        }
+        size_t const end = offset + 3;
+        bool const unconditional = jump == OPCODE_jump || jump == OPCODE_loop;
+        if (target >= end && target - end <= UINT16_MAX) {
+            if (unconditional) {
+                code[offset] = OPCODE_jump;
+            }
+            code[offset + 1] = (uint8_t)((target - end) >> 8);
+            code[offset + 2] = (uint8_t)((target - end) & 0xff);
+        } else if (target < end && unconditional &&
+                   end - target <= UINT16_MAX) {
+            code[offset] = OPCODE_loop;
+            code[offset + 1] = (uint8_t)((end - target) >> 8);
+            code[offset + 2] = (uint8_t)((end - target) & 0xff);
+        }
+    }
+}
+
+// Allocates the block of a frozen chunk and points the chunk's caches,
+// constants and code into it.
+static void allocate_frozen(Chunk* pChunk, size_t const shape_cache_count,
+                            size_t const constant_count, size_t const count) {
+    size_t const caches_size = sizeof(ShapeCache) * shape_cache_count;
+    size_t const constants_size = sizeof(Value) * constant_count;
+    size_t const size = caches_size + constants_size + count;
+    // Over-allocated to find the aligned start inside.
+    size_t const frozen_size = size + CLOX_CHUNK_CACHE_LINE - 1;
+    uint8_t* frozen = memory_reallocate(MEMORY_code, NULL, 0, frozen_size);
+    uint8_t* block =
+        (uint8_t*)(((uintptr_t)frozen + CLOX_CHUNK_CACHE_LINE - 1) &
+                   ~(uintptr_t)(CLOX_CHUNK_CACHE_LINE - 1));
+    pChunk->code = block + caches_size + constants_size;
+    pChunk->capacity = count;
+    pChunk->count = count;
+    pChunk->shape_caches = (ShapeCache*)block;
+    pChunk->shape_cache_count = shape_cache_count;
+    pChunk->shape_cache_capacity = shape_cache_count;
+    pChunk->constants = (ValueVector){.values = (Value*)(block + caches_size),
+                                      .count = constant_count,
+                                      .capacity = constant_count};
+    pChunk->frozen = frozen;
+    pChunk->frozen_size = frozen_size;
+}
+
+void chunk_freeze(Chunk* pChunk) {
+    assert(pChunk != NULL);
+    assert(pChunk->frozen == NULL);
+    Chunk const building = *pChunk;
+    allocate_frozen(pChunk, building.shape_cache_count,
+                    building.constants.count, building.count);
+    if (building.shape_cache_count > 0) {
+        memcpy(pChunk->shape_caches, building.shape_caches,
+               sizeof(*building.shape_caches) * building.shape_cache_count);
+    }
+    memcpy(pChunk->constants.values, building.constants.values,
+           sizeof(*building.constants.values) * building.constants.count);
+    memcpy(pChunk->code, building.code, building.count);
+
+    memory_reallocate(MEMORY_code, building.code,
+                      sizeof(*building.code) * building.capacity, 0);
+    ValueVector constants = building.constants;
+    value_vector_free(&constants);
+    memory_reallocate(
+        MEMORY_code, building.shape_caches,
+        sizeof(*building.shape_caches) * building.shape_cache_capacity, 0);
+    pChunk->line_vector = line_vector_shrink(building.line_vector);
+    thread_jumps(pChunk);
+    pChunk->stack_size = stack_size(pChunk);
+}
+
+Chunk chunk_new_frozen_alloc(uint8_t const* code, size_t const count,
+                             size_t const constant_count,
+                             size_t const shape_cache_count,
+                             LineInfo const* lines, size_t const line_count) {
+    Chunk chunk = {0};
+    allocate_frozen(&chunk, shape_cache_count, constant_count, count);
+    for (size_t i = 0; i < shape_cache_count; i++) {
+        chunk.shape_caches[i] = (ShapeCache){0};
+    }
+    for (size_t i = 0; i < constant_count; i++) {
+        chunk.constants.values[i] = VALUE_NIL;
+    }
+    if (count > 0) {
+        memcpy(chunk.code, code, count);
+    }
+    LineInfo* copy = memory_reallocate(MEMORY_lines, NULL, 0,
+                                       sizeof(*copy) * (line_count + 1));
+    if (line_count > 0) {
+        memcpy(copy, lines, sizeof(*copy) * line_count);
+    }
+    chunk.line_vector = line_vector_shrink((LineVector){
+        .lines = copy, .count = line_count, .capacity = line_count + 1});
+    chunk.stack_size = stack_size(&chunk);
+    return chunk;
+}
@@ -5,17 +5,88 @@
 #include <stdint.h>
 
 #include "line.h"  // LineVector
+#include "shape.h" // ShapeCache
 #include "value.h" // Value, ValueVector
 
 #define CLOX_CHUNK_MIN_CAPACITY 8
+#define CLOX_CHUNK_CACHE_LINE 64
+// Inline caches are addressed by a 16-bit operand.
+#define CLOX_CHUNK_SHAPE_CACHES_MAX (UINT16_MAX + 1)
 
 enum OPCODE {
     OPCODE_constant,
+    OPCODE_nil,
+    OPCODE_true,
+    OPCODE_false,
+    OPCODE_pop,
+    // Global operands are a 16-bit big-endian slot index.
+    OPCODE_define_global,
+    OPCODE_get_global,
+    OPCODE_set_global,
+    // Local operands are an 8-bit slot relative to the frame base.
+    OPCODE_get_local,
+    OPCODE_get_local_0,
+    OPCODE_get_local_1,
+    OPCODE_get_local_2,
+    OPCODE_get_local_3,
+    OPCODE_set_local,
     OPCODE_add,
     OPCODE_subtract,
     OPCODE_multiply,
     OPCODE_divide,
     OPCODE_negate,
+    OPCODE_not,
+    OPCODE_equal,
+    OPCODE_greater,
+    OPCODE_less,
+    // Arithmetic with the right operand loaded from a local slot.
+    OPCODE_add_local,
+    OPCODE_subtract_local,
+    OPCODE_multiply_local,
+    OPCODE_divide_local,
+    // Quickened forms of `add` and `add_local`. The compiler never emits
+    // them, the VM rewrites the generic instruction in place once it saw the
+    // operand types, and back when they stop matching.
+    OPCODE_add_num_num,
+    OPCODE_add_str_str,
+    OPCODE_add_local_num_num,
+    OPCODE_add_local_str_str,
+    // Jump operands are a 16-bit big-endian distance from the end of the
+    // instruction, backwards for `loop` and forwards for every other jump.
+    OPCODE_jump,
+    OPCODE_loop,
+    // Pops the condition.
+    OPCODE_jump_if_false,
+    // For `and` and `or`: jumps keeping the left operand as the result, or
+    // pops it and goes on to the right one.
+    OPCODE_jump_if_false_or_pop,
+    OPCODE_jump_if_true_or_pop,
+    // A comparison fused with the `jump_if_false` testing it, which the
+    // compiler emits when a condition ends with one. They pop both operands
+    // and jump on the outcome in their name, so no boolean is pushed.
+    // `a < b` compiles to `jump_if_not_less`, `a >= b`, which is `!(a < b)`,
+    // to `jump_if_less`.
+    OPCODE_jump_if_equal,
+    OPCODE_jump_if_not_equal,
+    OPCODE_jump_if_greater,
+    OPCODE_jump_if_not_greater,
+    OPCODE_jump_if_less,
+    OPCODE_jump_if_not_less,
+    // Operand is the constant with the class name.
+    OPCODE_class,
+    // Operand is the argument count.
+    OPCODE_call,
+    // A call whose result is returned right away. The compiler rewrites
+    // `call` to it when a `return` follows, and it reuses the frame.
+    OPCODE_tail_call,
+    // Operands are the constant with the property name and a 16-bit index
+    // of the instruction's inline cache.
+    OPCODE_get_property,
+    OPCODE_set_property,
+    OPCODE_print,
+    // Operand is a 16-bit module slot. Calls the module the first time it's
+    // imported and pushes its result, nil after that.
+    OPCODE_import,
     OPCODE_return
 };
 
@@ -25,6 +96,16 @@ typedef struct {
     size_t count;
     ValueVector constants;
     LineVector line_vector;
+    ShapeCache* shape_caches;
+    size_t shape_cache_count;
+    size_t shape_cache_capacity;
+    // Most values the code has on the stack at once, on top of the frame's
+    // callee and arguments. Known once the chunk is frozen.
+    size_t stack_size;
+    // Block holding the inline caches, the constants and the code once the
+    // chunk is frozen, NULL while it's being written.
+    void* frozen;
+    size_t frozen_size;
 } Chunk;
 
 Chunk chunk_new_alloc(void) __attribute__((warn_unused_result));
@@ -33,6 +114,30 @@ void chunk_free(Chunk* pChunk);
 
 void chunk_push(Chunk* pChunk, uint8_t const byte, int const line);
 
+// Drops every byte from offset `count` on, so the compiler can rewrite the
+// tail of the code it just emitted.
+void chunk_truncate(Chunk* pChunk, size_t const count);
+
 size_t chunk_add_constant(Chunk* pChunk, Value const value);
 
+// Returns the index of a new, empty inline cache.
+size_t chunk_add_shape_cache(Chunk* pChunk);
+
+// Packs the inline caches, the constants and the code of a finished chunk
+// into one cache-line aligned block without slack, in that order. Line
+// info, which is only read on errors, is shrunk in its own block. The code
+// and the caches stay writable, but nothing can be added anymore.
+// Also threads jumps, pointing those that land on another jump sure to be
+// taken where the last one goes, and computes the chunk's stack size.
+void chunk_freeze(Chunk* pChunk);
+
+// Creates a frozen chunk from the code and line info of one, with
+// `constant_count` nil constants for the caller to fill in and empty inline
+// caches. Snapshots are loaded with it.
+Chunk chunk_new_frozen_alloc(uint8_t const* code, size_t const count,
+                             size_t const constant_count,
+                             size_t const shape_cache_count,
+                             LineInfo const* lines, size_t const line_count)
+    __attribute__((warn_unused_result));
+
 #endif // !CLOX_CHUNK_H
@@ -1,15 +1,22 @@
 #include "compiler.h"
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <stdlib.h>
+#include <string.h>
 
 #include "chunk.h"   // Chunk, chunk_*
+#include "gc.h"      // GarbageCollector, gc_*
+#include "global.h"  // GlobalTable, global_table_*
+#include "memory.h"  // memory_*
+#include "module.h"  // ModuleTable, module_table_*
+#include "object.h"  // ObjectString, ObjectFunction, object_*
+#include "output.h"  // Output, output_*
 #include "scanner.h" // Scanner, scanner_*
 #include "token.h"   // Token
-#include "value.h"   // Value
+#include "value.h"   // Value, VALUE_*
 
 #define CLOX_DEBUG_PRINT_CODE
 
@@ -17,6 +24,42 @@
 #include "debug.h" // debug_*
 #endif
 
+#define CLOX_LOCALS_MAX (UINT8_MAX + 1)
+// Locals below this slot have their own operand-less GET_LOCAL opcodes.
+#define CLOX_SHORT_LOCALS 4
+
+typedef struct {
+    // Owned copy of the name, tokens don't outlive the scanner's buffers.
+    char* name;
+    int length;
+    // Scope depth the local was declared at, -1 until it's initialized.
+    int depth;
+} Local;
+
+typedef enum {
+    FUNCTION_TYPE_script,
+    FUNCTION_TYPE_function
+} FunctionType;
+
+// One per function being compiled, innermost first. Locals are kept in
+// declaration order, which is also their stack slot order relative to the
+// frame base.
+typedef struct Compiler {
+    struct Compiler* enclosing;
+    // NULL for the script, whose chunk is the one passed to the compiler.
+    ObjectFunction* function;
+    FunctionType type;
+    Local locals[CLOX_LOCALS_MAX];
+    int local_count;
+    int scope_depth;
+    // Offset of the last call instruction emitted into this function's
+    // chunk, to spot calls in tail position.
+    size_t last_call;
+    // Offset of the last comparison, which the jump testing a condition
+    // that ends with it takes in. SIZE_MAX once a jump lands after it.
+    size_t last_comparison;
+} Compiler;
+
 typedef struct {
     Token current;
     Token previous;
@@ -24,6 +67,12 @@ typedef struct {
     bool panic_mode;
     Chunk* chunk;
     Scanner* scanner;
+    GarbageCollector* gc;
+    GlobalTable* globals;
+    // NULL when compiling an expression, which can't import.
+    ModuleTable* modules;
+    Compiler* compiler;
+    Output* output;
 } Parser;
 
 typedef enum {
@@ -40,7 +89,7 @@ typedef enum {
     PREC_PRIMARY
 } Precedence;
 
-typedef void (*ParseFn)(Parser*);
+typedef void (*ParseFn)(Parser*, bool can_assign);
 
 typedef struct {
     ParseFn prefix;
@@ -49,7 +98,7 @@ typedef struct {
 } ParseRule;
 
 // Forward declaration of rules
-static ParseRule rules[];
+static ParseRule rules[TOKEN_EOF + 1];
 
 static ParseRule* get_rule(TokenType type) { return &rules[type]; }
 
@@ -100,6 +149,18 @@ static void consume(Parser* parser, TokenType type, char const* message) {
     error_at_current(parser, message);
 }
 
+static bool check(Parser const* parser, TokenType type) {
+    return parser->current.type == type;
+}
+
+static bool match(Parser* parser, TokenType type) {
+    if (!check(parser, type)) {
+        return false;
+    }
+    advance(parser);
+    return true;
+}
+
 static void emit_byte(Parser const* parser, uint8_t byte) {
     chunk_push(parser->chunk, byte, parser->previous.line);
 }
@@ -109,16 +170,89 @@ static void emit_bytes(Parser const* parser, uint8_t byte1, uint8_t byte2) {
     emit_byte(parser, byte2);
 }
 
+static void emit_short(Parser const* parser, uint8_t byte, uint16_t operand) {
+    emit_byte(parser, byte);
+    emit_bytes(parser, (uint8_t)(operand >> 8), (uint8_t)(operand & 0xff));
+}
+
+// Returns the offset of the operand, patched once the target is known.
+static size_t emit_jump(Parser const* parser, uint8_t opcode) {
+    emit_short(parser, opcode, UINT16_MAX);
+    return parser->chunk->count - 2;
+}
+
+// Points the jump whose operand is at `offset` at the next instruction.
+static void patch_jump(Parser* parser, size_t offset) {
+    Chunk* chunk = parser->chunk;
+    // The operand is jumped over too.
+    size_t const distance = chunk->count - offset - 2;
+    if (distance > UINT16_MAX) {
+        error(parser, "Too much code to jump over.");
+    }
+    chunk->code[offset] = (uint8_t)((distance >> 8) & 0xff);
+    chunk->code[offset + 1] = (uint8_t)(distance & 0xff);
+    // Fusing the comparison would leave this jump without the operands.
+    parser->compiler->last_comparison = SIZE_MAX;
+}
+
+static void emit_loop(Parser* parser, size_t start) {
+    // The loop instruction is jumped over too.
+    size_t const distance = parser->chunk->count + 3 - start;
+    if (distance > UINT16_MAX) {
+        error(parser, "Loop body too large.");
+    }
+    emit_short(parser, OPCODE_loop, (uint16_t)distance);
+}
+
+// The fused jump taken when a comparison is false, `negated` when it's
+// followed by the `not` that `!=`, `<=` and `>=` compile to.
+static uint8_t fused_jump(uint8_t comparison, bool negated) {
+    switch (comparison) {
+    case OPCODE_equal:
+        return negated ? OPCODE_jump_if_equal : OPCODE_jump_if_not_equal;
+    case OPCODE_greater:
+        return negated ? OPCODE_jump_if_greater : OPCODE_jump_if_not_greater;
+    default:
+        return negated ? OPCODE_jump_if_less : OPCODE_jump_if_not_less;
+    }
+}
+
+// Emits the jump over what runs when the condition just compiled is true.
+// A condition that ends with a comparison has it fused into the jump, which
+// then tests the operands itself. Returns the offset of the operand.
+static size_t emit_jump_if_false(Parser* parser) {
+    Chunk* chunk = parser->chunk;
+    size_t const comparison = parser->compiler->last_comparison;
+    if (comparison != SIZE_MAX &&
+        (comparison + 1 == chunk->count ||
+         (comparison + 2 == chunk->count &&
+          chunk->code[comparison + 1] == OPCODE_not))) {
+        uint8_t const jump = fused_jump(chunk->code[comparison],
+                                        comparison + 2 == chunk->count);
+        chunk_truncate(chunk, comparison);
+        parser->compiler->last_comparison = SIZE_MAX;
+        return emit_jump(parser, jump);
+    }
+    return emit_jump(parser, OPCODE_jump_if_false);
+}
+
 static void emit_return(Parser const* parser) {
+    emit_byte(parser, OPCODE_nil);
     emit_byte(parser, OPCODE_return);
 }
 
 static void end_compiler(Parser const* parser) {
-    emit_return(parser);
 #ifdef CLOX_DEBUG_PRINT_CODE
     if (parser->had_error) {
-        debug_disassemble_chunk(parser->chunk, "code");
+        ObjectFunction const* function = parser->compiler->function;
+        debug_disassemble_chunk(parser->output, parser->chunk,
+                                function != NULL ? function->name->chars
+                                                 : "code");
+        // Right after the errors, which went to stderr unbuffered.
+        output_flush(parser->output);
     }
+#else
+    (void)parser;
 #endif
 }
 
@@ -129,11 +263,15 @@ static void parsePrecedence(Parser* parser, Precedence precedence) {
         error(parser, "Expect expression.");
         return;
     }
-    prefix_rule(parser);
+    bool const can_assign = precedence <= PREC_ASSIGNMENT;
+    prefix_rule(parser, can_assign);
     while (precedence <= get_rule(parser->current.type)->precedence) {
         advance(parser);
         ParseFn infix_rule = get_rule(parser->previous.type)->infix;
-        infix_rule(parser);
+        infix_rule(parser, can_assign);
+    }
+    if (can_assign && match(parser, TOKEN_EQUAL)) {
+        error(parser, "Invalid assignment target.");
     }
 }
 
@@ -141,8 +279,38 @@ static void expression(Parser* parser) {
     parsePrecedence(parser, PREC_ASSIGNMENT);
 }
 
+// Numbers are compared by their bits, so that 0 and -0 stay apart.
+static bool same_constant(Value const a, Value const b) {
+    if (a.type != b.type) {
+        return false;
+    }
+    if (VALUE_IS_NUMBER(a)) {
+        double const x = VALUE_AS_NUMBER(a);
+        double const y = VALUE_AS_NUMBER(b);
+        return memcmp(&x, &y, sizeof(x)) == 0;
+    }
+    return VALUE_IS_OBJECT(a) && VALUE_AS_OBJECT(a) == VALUE_AS_OBJECT(b);
+}
+
 static uint8_t make_constant(Parser* parser, Value value) {
+    // Numbers and interned strings that are already constants are reused,
+    // so that only distinct literals count against the limit. The search
+    // stops at the limit, so it stays cheap.
+    ValueVector const* constants = &parser->chunk->constants;
+    size_t const searched = constants->count < UINT8_MAX + 1
+                                ? constants->count
+                                : UINT8_MAX + 1;
+    for (size_t i = 0; i < searched; i++) {
+        if (same_constant(constants->values[i], value)) {
+            return (uint8_t)i;
+        }
+    }
     size_t constant = chunk_add_constant(parser->chunk, value);
+    // Constants of a function are reached through the function.
+    ObjectFunction* function = parser->compiler->function;
+    if (function != NULL) {
+        gc_write_barrier(parser->gc, &function->object, value);
+    }
     if (constant > UINT8_MAX) {
         error(parser, "Too many constants in one chunk.");
         return 0;
@@ -154,22 +322,188 @@ static void emit_constant(Parser* parser, Value value) {
     emit_bytes(parser, OPCODE_constant, make_constant(parser, value));
 }
 
-static void number(Parser* parser) {
-    double value = strtod(parser->previous.start, NULL);
-    emit_constant(parser, value);
+static uint8_t identifier_constant(Parser* parser, Token const* name) {
+    ObjectString* string =
+        object_string_copy(parser->gc, name->start, name->length);
+    return make_constant(parser, VALUE_OBJECT(string));
+}
+
+static uint16_t global_slot(Parser* parser, Token const* name) {
+    size_t slot = global_table_resolve(parser->globals, name->start,
+                                       name->length);
+    if (slot >= CLOX_GLOBAL_MAX) {
+        error(parser, "Too many global variables.");
+        return 0;
+    }
+    return (uint16_t)slot;
+}
+
+static void number(Parser* parser, bool can_assign) {
+    (void)can_assign;
+    emit_constant(parser, VALUE_NUMBER(parser->previous.number));
+}
+
+static void string(Parser* parser, bool can_assign) {
+    (void)can_assign;
+    // Trim the surrounding quotes.
+    ObjectString* value = object_string_copy(
+        parser->gc, parser->previous.start + 1, parser->previous.length - 2);
+    emit_constant(parser, VALUE_OBJECT(value));
+}
+
+static void literal(Parser* parser, bool can_assign) {
+    (void)can_assign;
+    switch (parser->previous.type) {
+    case TOKEN_FALSE:
+        emit_byte(parser, OPCODE_false);
+        break;
+    case TOKEN_NIL:
+        emit_byte(parser, OPCODE_nil);
+        break;
+    case TOKEN_TRUE:
+        emit_byte(parser, OPCODE_true);
+        break;
+    default:
+        return; // Unreachable.
+    }
+}
+
+static bool local_is_named(Local const* local, Token const* name) {
+    return local->length == name->length &&
+           memcmp(local->name, name->start, name->length) == 0;
+}
+
+// Walks the locals from the innermost scope outwards, so the cost is the
+// number of locals in scope. Returns -1 for a global.
+static int resolve_local(Parser* parser, Token const* name) {
+    Compiler const* compiler = parser->compiler;
+    for (int i = compiler->local_count - 1; i >= 0; i--) {
+        Local const* local = &compiler->locals[i];
+        if (local_is_named(local, name)) {
+            if (local->depth == -1) {
+                error(parser, "Can't read local variable in its own "
+                              "initializer.");
+            }
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Locals of enclosing functions would need closures, which don't exist yet.
+static void check_not_captured(Parser* parser, Token const* name) {
+    for (Compiler const* compiler = parser->compiler->enclosing;
+         compiler != NULL; compiler = compiler->enclosing) {
+        for (int i = compiler->local_count - 1; i >= 1; i--) {
+            if (local_is_named(&compiler->locals[i], name)) {
+                error(parser, "Can't capture local variables, closures "
+                              "aren't supported yet.");
+                return;
+            }
+        }
+    }
+}
+
+static void emit_get_local(Parser* parser, uint8_t slot) {
+    if (slot < CLOX_SHORT_LOCALS) {
+        emit_byte(parser, (uint8_t)(OPCODE_get_local_0 + slot));
+    } else {
+        emit_bytes(parser, OPCODE_get_local, slot);
+    }
+}
+
+static void named_variable(Parser* parser, Token name, bool can_assign) {
+    int local = resolve_local(parser, &name);
+    if (local != -1) {
+        if (can_assign && match(parser, TOKEN_EQUAL)) {
+            expression(parser);
+            emit_bytes(parser, OPCODE_set_local, (uint8_t)local);
+        } else {
+            emit_get_local(parser, (uint8_t)local);
+        }
+        return;
+    }
+
+    check_not_captured(parser, &name);
+    uint16_t slot = global_slot(parser, &name);
+    if (can_assign && match(parser, TOKEN_EQUAL)) {
+        expression(parser);
+        emit_short(parser, OPCODE_set_global, slot);
+    } else {
+        emit_short(parser, OPCODE_get_global, slot);
+    }
+}
+
+static void variable(Parser* parser, bool can_assign) {
+    named_variable(parser, parser->previous, can_assign);
 }
 
-static void grouping(Parser* parser) {
+static void grouping(Parser* parser, bool can_assign) {
+    (void)can_assign;
     expression(parser);
     consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after expression.");
 }
 
-static void unary(Parser* parser) {
+static void this_(Parser* parser, bool can_assign) {
+    (void)can_assign;
+    // Methods need functions, so there is no class body `this` could be
+    // used in yet.
+    error(parser, "Can't use 'this' outside of a class.");
+}
+
+static uint8_t argument_list(Parser* parser) {
+    uint8_t count = 0;
+    if (!check(parser, TOKEN_RIGHT_PAREN)) {
+        do {
+            expression(parser);
+            if (count == UINT8_MAX) {
+                error(parser, "Can't have more than 255 arguments.");
+            } else {
+                count += 1;
+            }
+        } while (match(parser, TOKEN_COMMA));
+    }
+    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after arguments.");
+    return count;
+}
+
+static void call(Parser* parser, bool can_assign) {
+    (void)can_assign;
+    uint8_t const argument_count = argument_list(parser);
+    parser->compiler->last_call = parser->chunk->count;
+    emit_bytes(parser, OPCODE_call, argument_count);
+}
+
+static void emit_property(Parser* parser, uint8_t opcode, uint8_t name) {
+    size_t const cache = chunk_add_shape_cache(parser->chunk);
+    if (cache >= CLOX_CHUNK_SHAPE_CACHES_MAX) {
+        error(parser, "Too many property accesses in one chunk.");
+    }
+    emit_bytes(parser, opcode, name);
+    emit_bytes(parser, (uint8_t)(cache >> 8), (uint8_t)(cache & 0xff));
+}
+
+static void dot(Parser* parser, bool can_assign) {
+    consume(parser, TOKEN_IDENTIFIER, "Expect property name after '.'.");
+    uint8_t const name = identifier_constant(parser, &parser->previous);
+    if (can_assign && match(parser, TOKEN_EQUAL)) {
+        expression(parser);
+        emit_property(parser, OPCODE_set_property, name);
+    } else {
+        emit_property(parser, OPCODE_get_property, name);
+    }
+}
+
+static void unary(Parser* parser, bool can_assign) {
+    (void)can_assign;
     TokenType operator_type = parser->previous.type;
     // Compile the operand.
     parsePrecedence(parser, PREC_UNARY);
     // Emit the operator instruction.
     switch (operator_type) {
+    case TOKEN_BANG:
+        emit_byte(parser, OPCODE_not);
+        break;
     case TOKEN_MINUS:
         emit_byte(parser, OPCODE_negate);
         break;
@@ -178,81 +512,542 @@ static void unary(Parser* parser) {
     }
 }
 
-static void binary(Parser* parser) {
+// If the right operand of an arithmetic operator compiled to a single local
+// load, the load and the operator are fused into one instruction that reads
+// the local straight from its slot.
+static bool fuse_local_operand(Parser* parser, size_t operand_start,
+                               uint8_t fused) {
+    Chunk* chunk = parser->chunk;
+    size_t const length = chunk->count - operand_start;
+    if (length == 0) {
+        return false;
+    }
+    uint8_t const load = chunk->code[operand_start];
+    uint8_t slot;
+    if (length == 1 && load >= OPCODE_get_local_0 &&
+        load < OPCODE_get_local_0 + CLOX_SHORT_LOCALS) {
+        slot = (uint8_t)(load - OPCODE_get_local_0);
+    } else if (length == 2 && load == OPCODE_get_local) {
+        slot = chunk->code[operand_start + 1];
+    } else {
+        return false;
+    }
+    chunk_truncate(chunk, operand_start);
+    emit_bytes(parser, fused, slot);
+    return true;
+}
+
+// `!=`, `<=` and `>=` are the negation of `==`, `>` and `<`.
+static void emit_comparison(Parser* parser, uint8_t comparison,
+                            bool negated) {
+    parser->compiler->last_comparison = parser->chunk->count;
+    emit_byte(parser, comparison);
+    if (negated) {
+        emit_byte(parser, OPCODE_not);
+    }
+}
+
+static void binary(Parser* parser, bool can_assign) {
+    (void)can_assign;
     TokenType operator_type = parser->previous.type;
     ParseRule* rule = get_rule(operator_type);
+    size_t const operand_start = parser->chunk->count;
     parsePrecedence(parser, (Precedence)(rule->precedence + 1));
 
     switch (operator_type) {
+    case TOKEN_BANG_EQUAL:
+        emit_comparison(parser, OPCODE_equal, true);
+        break;
+    case TOKEN_EQUAL_EQUAL:
+        emit_comparison(parser, OPCODE_equal, false);
+        break;
+    case TOKEN_GREATER:
+        emit_comparison(parser, OPCODE_greater, false);
+        break;
+    case TOKEN_GREATER_EQUAL:
+        emit_comparison(parser, OPCODE_less, true);
+        break;
+    case TOKEN_LESS:
+        emit_comparison(parser, OPCODE_less, false);
+        break;
+    case TOKEN_LESS_EQUAL:
+        emit_comparison(parser, OPCODE_greater, true);
+        break;
     case TOKEN_PLUS:
-        emit_byte(parser, OPCODE_add);
+        if (!fuse_local_operand(parser, operand_start, OPCODE_add_local)) {
+            emit_byte(parser, OPCODE_add);
+        }
         break;
     case TOKEN_MINUS:
-        emit_byte(parser, OPCODE_subtract);
+        if (!fuse_local_operand(parser, operand_start,
+                                OPCODE_subtract_local)) {
+            emit_byte(parser, OPCODE_subtract);
+        }
         break;
     case TOKEN_STAR:
-        emit_byte(parser, OPCODE_multiply);
+        if (!fuse_local_operand(parser, operand_start,
+                                OPCODE_multiply_local)) {
+            emit_byte(parser, OPCODE_multiply);
+        }
         break;
     case TOKEN_SLASH:
-        emit_byte(parser, OPCODE_divide);
+        if (!fuse_local_operand(parser, operand_start, OPCODE_divide_local)) {
+            emit_byte(parser, OPCODE_divide);
+        }
         break;
     default:
         return; // Unreachable.
     }
 }
 
+// The left operand is the result if it decides it, and the right one
+// otherwise.
+static void and_(Parser* parser, bool can_assign) {
+    (void)can_assign;
+    size_t const end_jump = emit_jump(parser, OPCODE_jump_if_false_or_pop);
+    parsePrecedence(parser, PREC_AND);
+    patch_jump(parser, end_jump);
+}
+
+static void or_(Parser* parser, bool can_assign) {
+    (void)can_assign;
+    size_t const end_jump = emit_jump(parser, OPCODE_jump_if_true_or_pop);
+    parsePrecedence(parser, PREC_OR);
+    patch_jump(parser, end_jump);
+}
+
 static ParseRule rules[] = {
-    [TOKEN_LEFT_PAREN] = {grouping, NULL, PREC_NONE},
+    [TOKEN_LEFT_PAREN] = {grouping, call, PREC_CALL},
     [TOKEN_RIGHT_PAREN] = {NULL, NULL, PREC_NONE},
     [TOKEN_LEFT_BRACE] = {NULL, NULL, PREC_NONE},
     [TOKEN_RIGHT_BRACE] = {NULL, NULL, PREC_NONE},
     [TOKEN_COMMA] = {NULL, NULL, PREC_NONE},
-    [TOKEN_DOT] = {NULL, NULL, PREC_NONE},
+    [TOKEN_DOT] = {NULL, dot, PREC_CALL},
     [TOKEN_MINUS] = {unary, binary, PREC_TERM},
     [TOKEN_PLUS] = {NULL, binary, PREC_TERM},
     [TOKEN_SEMICOLON] = {NULL, NULL, PREC_NONE},
     [TOKEN_SLASH] = {NULL, binary, PREC_FACTOR},
     [TOKEN_STAR] = {NULL, binary, PREC_FACTOR},
-    [TOKEN_BANG] = {NULL, NULL, PREC_NONE},
-    [TOKEN_BANG_EQUAL] = {NULL, NULL, PREC_NONE},
+    [TOKEN_BANG] = {unary, NULL, PREC_NONE},
+    [TOKEN_BANG_EQUAL] = {NULL, binary, PREC_EQUALITY},
     [TOKEN_EQUAL] = {NULL, NULL, PREC_NONE},
-    [TOKEN_EQUAL_EQUAL] = {NULL, NULL, PREC_NONE},
-    [TOKEN_GREATER] = {NULL, NULL, PREC_NONE},
-    [TOKEN_GREATER_EQUAL] = {NULL, NULL, PREC_NONE},
-    [TOKEN_LESS] = {NULL, NULL, PREC_NONE},
-    [TOKEN_LESS_EQUAL] = {NULL, NULL, PREC_NONE},
-    [TOKEN_IDENTIFIER] = {NULL, NULL, PREC_NONE},
-    [TOKEN_STRING] = {NULL, NULL, PREC_NONE},
+    [TOKEN_EQUAL_EQUAL] = {NULL, binary, PREC_EQUALITY},
+    [TOKEN_GREATER] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_GREATER_EQUAL] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_LESS] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_LESS_EQUAL] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_IDENTIFIER] = {variable, NULL, PREC_NONE},
+    [TOKEN_STRING] = {string, NULL, PREC_NONE},
     [TOKEN_NUMBER] = {number, NULL, PREC_NONE},
-    [TOKEN_AND] = {NULL, NULL, PREC_NONE},
+    [TOKEN_AND] = {NULL, and_, PREC_AND},
     [TOKEN_CLASS] = {NULL, NULL, PREC_NONE},
     [TOKEN_ELSE] = {NULL, NULL, PREC_NONE},
-    [TOKEN_FALSE] = {NULL, NULL, PREC_NONE},
+    [TOKEN_FALSE] = {literal, NULL, PREC_NONE},
     [TOKEN_FOR] = {NULL, NULL, PREC_NONE},
     [TOKEN_FUN] = {NULL, NULL, PREC_NONE},
     [TOKEN_IF] = {NULL, NULL, PREC_NONE},
-    [TOKEN_NIL] = {NULL, NULL, PREC_NONE},
-    [TOKEN_OR] = {NULL, NULL, PREC_NONE},
+    [TOKEN_IMPORT] = {NULL, NULL, PREC_NONE},
+    [TOKEN_NIL] = {literal, NULL, PREC_NONE},
+    [TOKEN_OR] = {NULL, or_, PREC_OR},
     [TOKEN_PRINT] = {NULL, NULL, PREC_NONE},
     [TOKEN_RETURN] = {NULL, NULL, PREC_NONE},
     [TOKEN_SUPER] = {NULL, NULL, PREC_NONE},
-    [TOKEN_THIS] = {NULL, NULL, PREC_NONE},
-    [TOKEN_TRUE] = {NULL, NULL, PREC_NONE},
+    [TOKEN_THIS] = {this_, NULL, PREC_NONE},
+    [TOKEN_TRUE] = {literal, NULL, PREC_NONE},
     [TOKEN_VAR] = {NULL, NULL, PREC_NONE},
     [TOKEN_WHILE] = {NULL, NULL, PREC_NONE},
     [TOKEN_ERROR] = {NULL, NULL, PREC_NONE},
     [TOKEN_EOF] = {NULL, NULL, PREC_NONE},
 };
 
-bool compiler_compile(char const* source, Chunk* chunk) {
-    Scanner scanner = scanner_new(source);
+static void declaration(Parser* parser);
+static void statement(Parser* parser);
+static void var_declaration(Parser* parser);
+
+static void begin_scope(Parser* parser) { parser->compiler->scope_depth += 1; }
+
+static void end_scope(Parser* parser) {
+    Compiler* compiler = parser->compiler;
+    compiler->scope_depth -= 1;
+    while (compiler->local_count > 0 &&
+           compiler->locals[compiler->local_count - 1].depth >
+               compiler->scope_depth) {
+        emit_byte(parser, OPCODE_pop);
+        compiler->local_count -= 1;
+        Local const* local = &compiler->locals[compiler->local_count];
+        memory_reallocate(MEMORY_source, local->name, local->length, 0);
+    }
+}
+
+static void block(Parser* parser) {
+    while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF)) {
+        declaration(parser);
+    }
+    consume(parser, TOKEN_RIGHT_BRACE, "Expect '}' after block.");
+}
+
+static void expression_statement(Parser* parser) {
+    expression(parser);
+    consume(parser, TOKEN_SEMICOLON, "Expect ';' after expression.");
+    emit_byte(parser, OPCODE_pop);
+}
+
+static void print_statement(Parser* parser) {
+    expression(parser);
+    consume(parser, TOKEN_SEMICOLON, "Expect ';' after value.");
+    emit_byte(parser, OPCODE_print);
+}
+
+static void import_statement(Parser* parser) {
+    consume(parser, TOKEN_STRING, "Expect module path after 'import'.");
+    Token const* path = &parser->previous;
+    assert(parser->modules != NULL);
+    // The quotes aren't part of the path.
+    size_t const slot = module_table_resolve(parser->modules, path->start + 1,
+                                             path->length - 2);
+    if (slot >= CLOX_MODULE_MAX) {
+        error(parser, "Too many modules.");
+    }
+    consume(parser, TOKEN_SEMICOLON, "Expect ';' after module path.");
+    emit_short(parser, OPCODE_import, (uint16_t)slot);
+    // The import has the value of the module, which is nil.
+    emit_byte(parser, OPCODE_pop);
+}
+
+static void if_statement(Parser* parser) {
+    consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'if'.");
+    expression(parser);
+    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
+    size_t const then_jump = emit_jump_if_false(parser);
+    statement(parser);
+    if (match(parser, TOKEN_ELSE)) {
+        size_t const else_jump = emit_jump(parser, OPCODE_jump);
+        patch_jump(parser, then_jump);
+        statement(parser);
+        patch_jump(parser, else_jump);
+    } else {
+        patch_jump(parser, then_jump);
+    }
+}
+
+static void while_statement(Parser* parser) {
+    size_t const loop_start = parser->chunk->count;
+    consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'while'.");
+    expression(parser);
+    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
+    size_t const exit_jump = emit_jump_if_false(parser);
+    statement(parser);
+    emit_loop(parser, loop_start);
+    patch_jump(parser, exit_jump);
+}
+
+// The increment comes before the body in the code, so the body is jumped
+// to and loops back to the increment, which loops back to the condition.
+static void for_statement(Parser* parser) {
+    begin_scope(parser);
+    consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'for'.");
+    if (match(parser, TOKEN_SEMICOLON)) {
+        // No initializer.
+    } else if (match(parser, TOKEN_VAR)) {
+        var_declaration(parser);
+    } else {
+        expression_statement(parser);
+    }
+
+    size_t loop_start = parser->chunk->count;
+    size_t exit_jump = SIZE_MAX;
+    if (!match(parser, TOKEN_SEMICOLON)) {
+        expression(parser);
+        consume(parser, TOKEN_SEMICOLON, "Expect ';' after loop condition.");
+        exit_jump = emit_jump_if_false(parser);
+    }
+    if (!match(parser, TOKEN_RIGHT_PAREN)) {
+        size_t const body_jump = emit_jump(parser, OPCODE_jump);
+        size_t const increment_start = parser->chunk->count;
+        expression(parser);
+        emit_byte(parser, OPCODE_pop);
+        consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after for clauses.");
+        emit_loop(parser, loop_start);
+        loop_start = increment_start;
+        patch_jump(parser, body_jump);
+    }
+
+    statement(parser);
+    emit_loop(parser, loop_start);
+    if (exit_jump != SIZE_MAX) {
+        patch_jump(parser, exit_jump);
+    }
+    end_scope(parser);
+}
+
+static void return_statement(Parser* parser) {
+    if (parser->compiler->type == FUNCTION_TYPE_script) {
+        error(parser, "Can't return from top-level code.");
+    }
+    if (match(parser, TOKEN_SEMICOLON)) {
+        emit_return(parser);
+        return;
+    }
+    expression(parser);
+    consume(parser, TOKEN_SEMICOLON, "Expect ';' after return value.");
+    // A call that is the last thing evaluated is in tail position, so the
+    // callee can take over the frame.
+    Chunk* chunk = parser->chunk;
+    if (chunk->count >= 2 && parser->compiler->last_call == chunk->count - 2) {
+        chunk->code[chunk->count - 2] = OPCODE_tail_call;
+    }
+    emit_byte(parser, OPCODE_return);
+}
+
+static void statement(Parser* parser) {
+    if (match(parser, TOKEN_PRINT)) {
+        print_statement(parser);
+    } else if (match(parser, TOKEN_IF)) {
+        if_statement(parser);
+    } else if (match(parser, TOKEN_WHILE)) {
+        while_statement(parser);
+    } else if (match(parser, TOKEN_FOR)) {
+        for_statement(parser);
+    } else if (match(parser, TOKEN_IMPORT)) {
+        import_statement(parser);
+    } else if (match(parser, TOKEN_RETURN)) {
+        return_statement(parser);
+    } else if (match(parser, TOKEN_LEFT_BRACE)) {
+        begin_scope(parser);
+        block(parser);
+        end_scope(parser);
+    } else {
+        expression_statement(parser);
+    }
+}
+
+static void add_local(Parser* parser, Token const* name) {
+    Compiler* compiler = parser->compiler;
+    if (compiler->local_count == CLOX_LOCALS_MAX) {
+        error(parser, "Too many local variables in function.");
+        return;
+    }
+    Local* local = &compiler->locals[compiler->local_count];
+    compiler->local_count += 1;
+    local->name = memory_reallocate(MEMORY_source, NULL, 0, name->length);
+    memcpy(local->name, name->start, name->length);
+    local->length = name->length;
+    local->depth = -1;
+}
+
+static void declare_local(Parser* parser) {
+    Compiler const* compiler = parser->compiler;
+    Token const* name = &parser->previous;
+    for (int i = compiler->local_count - 1; i >= 0; i--) {
+        Local const* local = &compiler->locals[i];
+        if (local->depth != -1 && local->depth < compiler->scope_depth) {
+            break;
+        }
+        if (local_is_named(local, name)) {
+            error(parser, "Already a variable with this name in this scope.");
+        }
+    }
+    add_local(parser, name);
+}
+
+// Declares the variable named by the previous token. Returns its global
+// slot, which is meaningless for a local.
+static uint16_t declare_variable(Parser* parser) {
+    if (parser->compiler->scope_depth > 0) {
+        declare_local(parser);
+        return 0;
+    }
+    return global_slot(parser, &parser->previous);
+}
+
+static void define_variable(Parser* parser, uint16_t slot) {
+    Compiler* compiler = parser->compiler;
+    if (compiler->scope_depth > 0) {
+        // The initializer's value already sits in the local's slot.
+        compiler->locals[compiler->local_count - 1].depth =
+            compiler->scope_depth;
+    } else {
+        emit_short(parser, OPCODE_define_global, slot);
+    }
+}
+
+static void var_declaration(Parser* parser) {
+    consume(parser, TOKEN_IDENTIFIER, "Expect variable name.");
+    uint16_t const slot = declare_variable(parser);
+    if (match(parser, TOKEN_EQUAL)) {
+        expression(parser);
+    } else {
+        emit_byte(parser, OPCODE_nil);
+    }
+    consume(parser, TOKEN_SEMICOLON,
+            "Expect ';' after variable declaration.");
+    define_variable(parser, slot);
+}
+
+static void free_locals(Compiler const* compiler) {
+    // Slot 0 has no name. Scopes are left open when compiling stops at an
+    // error, and a function's outermost scope is never closed.
+    for (int i = 1; i < compiler->local_count; i++) {
+        memory_reallocate(MEMORY_source, compiler->locals[i].name,
+                          compiler->locals[i].length, 0);
+    }
+}
+
+static void begin_compiler(Parser* parser, Compiler* compiler,
+                           FunctionType const type,
+                           ObjectFunction* function) {
+    compiler->enclosing = parser->compiler;
+    compiler->function = function;
+    compiler->type = type;
+    // Slot 0 of every frame is reserved for the callee.
+    compiler->local_count = 1;
+    compiler->locals[0] = (Local){.name = NULL, .length = 0, .depth = 0};
+    compiler->scope_depth = 0;
+    compiler->last_call = SIZE_MAX;
+    compiler->last_comparison = SIZE_MAX;
+    parser->compiler = compiler;
+}
+
+// Compiles the parameters and body of the function named by the previous
+// token, and emits the constant that loads it.
+static void function(Parser* parser, FunctionType const type) {
+    // The function becomes a constant of the enclosing chunk before anything
+    // else is allocated, which keeps it and its own constants reachable.
+    ObjectFunction* function = object_function_new(parser->gc);
+    uint8_t const constant = make_constant(parser, VALUE_OBJECT(function));
+    function->name = object_string_copy(parser->gc, parser->previous.start,
+                                        parser->previous.length);
+    gc_write_barrier(parser->gc, &function->object,
+                     VALUE_OBJECT(function->name));
+
+    Chunk* enclosing_chunk = parser->chunk;
+    Compiler compiler;
+    begin_compiler(parser, &compiler, type, function);
+    parser->chunk = &function->chunk;
+    begin_scope(parser);
+
+    consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after function name.");
+    if (!check(parser, TOKEN_RIGHT_PAREN)) {
+        do {
+            if (function->arity == UINT8_MAX) {
+                error_at_current(parser, "Can't have more than 255 "
+                                         "parameters.");
+            }
+            function->arity += 1;
+            consume(parser, TOKEN_IDENTIFIER, "Expect parameter name.");
+            define_variable(parser, declare_variable(parser));
+        } while (match(parser, TOKEN_COMMA));
+    }
+    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after parameters.");
+    consume(parser, TOKEN_LEFT_BRACE, "Expect '{' before function body.");
+    block(parser);
+
+    emit_return(parser);
+    end_compiler(parser);
+    chunk_freeze(&function->chunk);
+    free_locals(&compiler);
+    parser->compiler = compiler.enclosing;
+    parser->chunk = enclosing_chunk;
+    emit_bytes(parser, OPCODE_constant, constant);
+}
+
+static void fun_declaration(Parser* parser) {
+    consume(parser, TOKEN_IDENTIFIER, "Expect function name.");
+    uint16_t const slot = declare_variable(parser);
+    function(parser, FUNCTION_TYPE_function);
+    define_variable(parser, slot);
+}
+
+static void class_declaration(Parser* parser) {
+    consume(parser, TOKEN_IDENTIFIER, "Expect class name.");
+    uint8_t const name = identifier_constant(parser, &parser->previous);
+    uint16_t const slot = declare_variable(parser);
+    emit_bytes(parser, OPCODE_class, name);
+    define_variable(parser, slot);
+    consume(parser, TOKEN_LEFT_BRACE, "Expect '{' before class body.");
+    if (!check(parser, TOKEN_RIGHT_BRACE)) {
+        error_at_current(parser, "Methods aren't supported yet.");
+    }
+    consume(parser, TOKEN_RIGHT_BRACE, "Expect '}' after class body.");
+}
+
+static void synchronize(Parser* parser) {
+    parser->panic_mode = false;
+    while (parser->current.type != TOKEN_EOF) {
+        if (parser->previous.type == TOKEN_SEMICOLON) {
+            return;
+        }
+        switch (parser->current.type) {
+        case TOKEN_CLASS:
+        case TOKEN_FUN:
+        case TOKEN_VAR:
+        case TOKEN_FOR:
+        case TOKEN_IF:
+        case TOKEN_IMPORT:
+        case TOKEN_WHILE:
+        case TOKEN_PRINT:
+        case TOKEN_RETURN:
+            return;
+        default:; // Do nothing.
+        }
+        advance(parser);
+    }
+}
+
+static void declaration(Parser* parser) {
+    if (match(parser, TOKEN_CLASS)) {
+        class_declaration(parser);
+    } else if (match(parser, TOKEN_FUN)) {
+        fun_declaration(parser);
+    } else if (match(parser, TOKEN_VAR)) {
+        var_declaration(parser);
+    } else {
+        statement(parser);
+    }
+    if (parser->panic_mode) {
+        synchronize(parser);
+    }
+}
+
+static bool compile(Scanner* pScanner, Chunk* chunk, GarbageCollector* pGc,
+                    GlobalTable* pGlobals, ModuleTable* pModules,
+                    Output* pOutput, bool const is_expression) {
     Parser parser = {.had_error = false,
                      .panic_mode = false,
                      .chunk = chunk,
-                     .scanner = &scanner};
+                     .scanner = pScanner,
+                     .gc = pGc,
+                     .globals = pGlobals,
+                     .modules = pModules,
+                     .compiler = NULL,
+                     .output = pOutput};
+    Compiler compiler;
+    begin_compiler(&parser, &compiler, FUNCTION_TYPE_script, NULL);
     advance(&parser);
-    expression(&parser);
-    consume(&parser, TOKEN_EOF, "Expect end of expression.");
+    if (is_expression) {
+        expression(&parser);
+        consume(&parser, TOKEN_EOF, "Expect end of expression.");
+        // Returns the expression's value.
+        emit_byte(&parser, OPCODE_return);
+    } else {
+        while (!match(&parser, TOKEN_EOF)) {
+            declaration(&parser);
+        }
+        emit_return(&parser);
+    }
     end_compiler(&parser);
+    free_locals(&compiler);
     return !parser.had_error;
 }
+
+bool compiler_compile(Scanner* pScanner, Chunk* chunk, GarbageCollector* pGc,
+                      GlobalTable* pGlobals, ModuleTable* pModules,
+                      Output* pOutput) {
+    return compile(pScanner, chunk, pGc, pGlobals, pModules, pOutput, false);
+}
+
+bool compiler_compile_expression(Scanner* pScanner, Chunk* chunk,
+                                 GarbageCollector* pGc, GlobalTable* pGlobals,
+                                 Output* pOutput) {
+    return compile(pScanner, chunk, pGc, pGlobals, NULL, pOutput, true);
+}
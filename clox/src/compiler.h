@@ -3,8 +3,26 @@
 
 #include <stdbool.h>
 
-#include "chunk.h" // Chunk
+#include "chunk.h"   // Chunk
+#include "gc.h"      // GarbageCollector
+#include "global.h"  // GlobalTable
+#include "module.h"  // ModuleTable
+#include "output.h"  // Output
+#include "scanner.h" // Scanner
 
-bool compiler_compile(char const* source, Chunk* chunk);
+// String constants are allocated on `pGc`, so the chunk must be reachable
+// from its roots while compiling. Global names are resolved to slots of
+// `pGlobals` and imported paths to slots of `pModules`, which must be the
+// tables of the VM that runs the chunk. The modules aren't loaded, that's
+// up to the caller. Debug output goes to `pOutput`.
+bool compiler_compile(Scanner* pScanner, Chunk* chunk, GarbageCollector* pGc,
+                      GlobalTable* pGlobals, ModuleTable* pModules,
+                      Output* pOutput);
+
+// Compiles a single expression instead of a script. The chunk returns with
+// the expression's value on top of the stack.
+bool compiler_compile_expression(Scanner* pScanner, Chunk* chunk,
+                                 GarbageCollector* pGc, GlobalTable* pGlobals,
+                                 Output* pOutput);
 
 #endif // !CLOX_COMPILER_H
@@ -2,60 +2,192 @@
 
 #include <stddef.h>
 #include <stdint.h>
-#include <stdio.h>
 
-#include "chunk.h" // Chunk, OPCODE_*
-#include "line.h"  // line_vector_*
-#include "value.h" // value_*
+#include "chunk.h"  // Chunk, OPCODE_*
+#include "line.h"   // line_vector_*
+#include "output.h" // Output, output_*
+#include "value.h"  // value_*
 
-static size_t simple_instruction(char const* name, int offset) {
-    printf("%s\n", name);
+static size_t simple_instruction(Output* pOutput, char const* name,
+                                 int offset) {
+    output_write_string(pOutput, name);
+    output_write_char(pOutput, '\n');
     return offset + 1;
 }
 
-static size_t constant_instruction(char const* name, Chunk const* chunk,
-                                   size_t offset) {
+static size_t constant_instruction(Output* pOutput, char const* name,
+                                   Chunk const* chunk, size_t offset) {
     uint8_t constant = chunk->code[offset + 1];
-    printf("%-16s %4d '", name, constant);
-    value_print(chunk->constants.values[constant]);
-    printf("'\n");
+    output_printf(pOutput, "%-16s %4d '", name, constant);
+    value_print(pOutput, chunk->constants.values[constant]);
+    output_write_string(pOutput, "'\n");
     return offset + 2;
 }
 
-void debug_disassemble_chunk(Chunk const* chunk, char const* name) {
-    printf("== %s == \n", name);
+static size_t global_instruction(Output* pOutput, char const* name,
+                                 Chunk const* chunk, size_t offset) {
+    uint16_t slot =
+        (uint16_t)(chunk->code[offset + 1] << 8 | chunk->code[offset + 2]);
+    output_printf(pOutput, "%-16s %4d\n", name, slot);
+    return offset + 3;
+}
+
+static size_t byte_instruction(Output* pOutput, char const* name,
+                               Chunk const* chunk, size_t offset) {
+    uint8_t slot = chunk->code[offset + 1];
+    output_printf(pOutput, "%-16s %4d\n", name, slot);
+    return offset + 2;
+}
+
+// Prints where the jump lands rather than how far it goes.
+static size_t jump_instruction(Output* pOutput, char const* name, int sign,
+                               Chunk const* chunk, size_t offset) {
+    uint16_t distance =
+        (uint16_t)(chunk->code[offset + 1] << 8 | chunk->code[offset + 2]);
+    output_printf(pOutput, "%-16s %4zu -> %zu\n", name, offset,
+                  offset + 3 + sign * (long)distance);
+    return offset + 3;
+}
+
+static size_t property_instruction(Output* pOutput, char const* name,
+                                   Chunk const* chunk, size_t offset) {
+    uint8_t constant = chunk->code[offset + 1];
+    uint16_t cache =
+        (uint16_t)(chunk->code[offset + 2] << 8 | chunk->code[offset + 3]);
+    output_printf(pOutput, "%-16s %4d '", name, constant);
+    value_print(pOutput, chunk->constants.values[constant]);
+    output_printf(pOutput, "' cache %d\n", cache);
+    return offset + 4;
+}
+
+void debug_disassemble_chunk(Output* pOutput, Chunk const* chunk,
+                             char const* name) {
+    output_printf(pOutput, "== %s == \n", name);
     for (size_t offset = 0; offset < chunk->count;) {
-        offset = debug_disassemble_instruction(chunk, offset);
+        offset = debug_disassemble_instruction(pOutput, chunk, offset);
     }
 }
 
-size_t debug_disassemble_instruction(Chunk const* chunk, size_t offset) {
-    printf("%04zu ", offset);
+size_t debug_disassemble_instruction(Output* pOutput, Chunk const* chunk,
+                                     size_t offset) {
+    output_printf(pOutput, "%04zu ", offset);
     int line = line_vector_get_line(chunk->line_vector, offset);
     if (offset > 0 &&
         line == line_vector_get_line(chunk->line_vector, offset - 1)) {
-        printf("   | ");
+        output_write_string(pOutput, "   | ");
     } else {
-        printf("%4d ", line);
+        output_printf(pOutput, "%4d ", line);
     }
     uint8_t const instruction = chunk->code[offset];
     switch (instruction) {
     case OPCODE_constant:
-        return constant_instruction("OP_CONSTANT", chunk, offset);
+        return constant_instruction(pOutput, "OP_CONSTANT", chunk, offset);
+    case OPCODE_nil:
+        return simple_instruction(pOutput, "OP_NIL", offset);
+    case OPCODE_true:
+        return simple_instruction(pOutput, "OP_TRUE", offset);
+    case OPCODE_false:
+        return simple_instruction(pOutput, "OP_FALSE", offset);
+    case OPCODE_pop:
+        return simple_instruction(pOutput, "OP_POP", offset);
+    case OPCODE_define_global:
+        return global_instruction(pOutput, "OP_DEFINE_GLOBAL", chunk, offset);
+    case OPCODE_get_global:
+        return global_instruction(pOutput, "OP_GET_GLOBAL", chunk, offset);
+    case OPCODE_set_global:
+        return global_instruction(pOutput, "OP_SET_GLOBAL", chunk, offset);
+    case OPCODE_get_local:
+        return byte_instruction(pOutput, "OP_GET_LOCAL", chunk, offset);
+    case OPCODE_get_local_0:
+        return simple_instruction(pOutput, "OP_GET_LOCAL_0", offset);
+    case OPCODE_get_local_1:
+        return simple_instruction(pOutput, "OP_GET_LOCAL_1", offset);
+    case OPCODE_get_local_2:
+        return simple_instruction(pOutput, "OP_GET_LOCAL_2", offset);
+    case OPCODE_get_local_3:
+        return simple_instruction(pOutput, "OP_GET_LOCAL_3", offset);
+    case OPCODE_set_local:
+        return byte_instruction(pOutput, "OP_SET_LOCAL", chunk, offset);
     case OPCODE_add:
-        return simple_instruction("OP_ADD", offset);
+        return simple_instruction(pOutput, "OP_ADD", offset);
     case OPCODE_subtract:
-        return simple_instruction("OP_SUBTRACT", offset);
+        return simple_instruction(pOutput, "OP_SUBTRACT", offset);
     case OPCODE_multiply:
-        return simple_instruction("OP_MULTIPLY", offset);
+        return simple_instruction(pOutput, "OP_MULTIPLY", offset);
     case OPCODE_divide:
-        return simple_instruction("OP_DIVIDE", offset);
+        return simple_instruction(pOutput, "OP_DIVIDE", offset);
     case OPCODE_negate:
-        return simple_instruction("OP_NEGATE", offset);
+        return simple_instruction(pOutput, "OP_NEGATE", offset);
+    case OPCODE_not:
+        return simple_instruction(pOutput, "OP_NOT", offset);
+    case OPCODE_equal:
+        return simple_instruction(pOutput, "OP_EQUAL", offset);
+    case OPCODE_greater:
+        return simple_instruction(pOutput, "OP_GREATER", offset);
+    case OPCODE_less:
+        return simple_instruction(pOutput, "OP_LESS", offset);
+    case OPCODE_add_local:
+        return byte_instruction(pOutput, "OP_ADD_LOCAL", chunk, offset);
+    case OPCODE_subtract_local:
+        return byte_instruction(pOutput, "OP_SUBTRACT_LOCAL", chunk, offset);
+    case OPCODE_multiply_local:
+        return byte_instruction(pOutput, "OP_MULTIPLY_LOCAL", chunk, offset);
+    case OPCODE_divide_local:
+        return byte_instruction(pOutput, "OP_DIVIDE_LOCAL", chunk, offset);
+    case OPCODE_add_num_num:
+        return simple_instruction(pOutput, "OP_ADD_NUM_NUM", offset);
+    case OPCODE_add_str_str:
+        return simple_instruction(pOutput, "OP_ADD_STR_STR", offset);
+    case OPCODE_add_local_num_num:
+        return byte_instruction(pOutput, "OP_ADD_LOCAL_NUM_NUM", chunk, offset);
+    case OPCODE_add_local_str_str:
+        return byte_instruction(pOutput, "OP_ADD_LOCAL_STR_STR", chunk, offset);
+    case OPCODE_jump:
+        return jump_instruction(pOutput, "OP_JUMP", 1, chunk, offset);
+    case OPCODE_loop:
+        return jump_instruction(pOutput, "OP_LOOP", -1, chunk, offset);
+    case OPCODE_jump_if_false:
+        return jump_instruction(pOutput, "OP_JUMP_IF_FALSE", 1, chunk, offset);
+    case OPCODE_jump_if_false_or_pop:
+        return jump_instruction(pOutput, "OP_JUMP_IF_FALSE_OR_POP", 1, chunk,
+                                offset);
+    case OPCODE_jump_if_true_or_pop:
+        return jump_instruction(pOutput, "OP_JUMP_IF_TRUE_OR_POP", 1, chunk,
+                                offset);
+    case OPCODE_jump_if_equal:
+        return jump_instruction(pOutput, "OP_JUMP_IF_EQUAL", 1, chunk, offset);
+    case OPCODE_jump_if_not_equal:
+        return jump_instruction(pOutput, "OP_JUMP_IF_NOT_EQUAL", 1, chunk,
+                                offset);
+    case OPCODE_jump_if_greater:
+        return jump_instruction(pOutput, "OP_JUMP_IF_GREATER", 1, chunk,
+                                offset);
+    case OPCODE_jump_if_not_greater:
+        return jump_instruction(pOutput, "OP_JUMP_IF_NOT_GREATER", 1, chunk,
+                                offset);
+    case OPCODE_jump_if_less:
+        return jump_instruction(pOutput, "OP_JUMP_IF_LESS", 1, chunk, offset);
+    case OPCODE_jump_if_not_less:
+        return jump_instruction(pOutput, "OP_JUMP_IF_NOT_LESS", 1, chunk,
+                                offset);
+    case OPCODE_class:
+        return constant_instruction(pOutput, "OP_CLASS", chunk, offset);
+    case OPCODE_call:
+        return byte_instruction(pOutput, "OP_CALL", chunk, offset);
+    case OPCODE_tail_call:
+        return byte_instruction(pOutput, "OP_TAIL_CALL", chunk, offset);
+    case OPCODE_get_property:
+        return property_instruction(pOutput, "OP_GET_PROPERTY", chunk, offset);
+    case OPCODE_set_property:
+        return property_instruction(pOutput, "OP_SET_PROPERTY", chunk, offset);
+    case OPCODE_print:
+        return simple_instruction(pOutput, "OP_PRINT", offset);
+    case OPCODE_import:
+        return global_instruction(pOutput, "OP_IMPORT", chunk, offset);
     case OPCODE_return:
-        return simple_instruction("OP_RETURN", offset);
+        return simple_instruction(pOutput, "OP_RETURN", offset);
     default:
-        printf("Unknown opcode %d\n", instruction);
+        output_printf(pOutput, "Unknown opcode %d\n", instruction);
         return offset + 1;
     }
 }
@@ -3,10 +3,13 @@
 
 #include <stddef.h>
 
-#include "chunk.h" // Chunk
+#include "chunk.h"  // Chunk
+#include "output.h" // Output
 
-void debug_disassemble_chunk(Chunk const* chunk, char const* name);
+void debug_disassemble_chunk(Output* pOutput, Chunk const* chunk,
+                             char const* name);
 
-size_t debug_disassemble_instruction(Chunk const* chunk, size_t offset);
+size_t debug_disassemble_instruction(Output* pOutput, Chunk const* chunk,
+                                     size_t offset);
 
 #endif // !CLOX_DEBUG_H
@@ -0,0 +1,345 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "gc.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "allocator.h" // Allocator, allocator_*
+#include "intern.h"    // intern_table_*
+#include "memory.h"    // memory_*
+#include "object.h"    // Object, OBJECT_*, object_*
+#include "shape.h"     // Shape
+#include "value.h"     // Value
+
+#define CLOX_GC_GRAY_MIN_CAPACITY 64
+
+static uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+static void record_pause(GarbageCollector* pGc, uint64_t const start) {
+    uint64_t const pause = now_ns() - start;
+    pGc->stats.steps += 1;
+    pGc->stats.pause_last_ns = pause;
+    pGc->stats.pause_total_ns += pause;
+    if (pause > pGc->stats.pause_max_ns) {
+        pGc->stats.pause_max_ns = pause;
+    }
+}
+
+static bool is_white(Object const* object) {
+    return object->color == GC_COLOR_white0 ||
+           object->color == GC_COLOR_white1;
+}
+
+static void push_gray(GarbageCollector* pGc, Object* object) {
+    if (pGc->gray_count >= pGc->gray_capacity) {
+        size_t const capacity =
+            (pGc->gray_capacity < CLOX_GC_GRAY_MIN_CAPACITY
+                 ? CLOX_GC_GRAY_MIN_CAPACITY
+                 : pGc->gray_capacity * 2);
+        // The gray stack is collector bookkeeping, so it is not allocated
+        // through gc_reallocate() to avoid re-entering the collector.
+        pGc->gray = memory_reallocate(
+            MEMORY_heap, pGc->gray, sizeof(*pGc->gray) * pGc->gray_capacity,
+            sizeof(*pGc->gray) * capacity);
+        pGc->gray_capacity = capacity;
+    }
+    pGc->gray[pGc->gray_count] = object;
+    pGc->gray_count += 1;
+}
+
+// Turns a gray object black by graying everything it references. Returns
+// the amount of work done, measured in bytes scanned.
+static size_t blacken(GarbageCollector* pGc, Object* object) {
+    object->color = GC_COLOR_black;
+    switch (object->type) {
+    case OBJECT_string:
+        break;
+    case OBJECT_function: {
+        ObjectFunction* function = (ObjectFunction*)object;
+        gc_mark_object(pGc, (Object*)function->name);
+        for (size_t i = 0; i < function->chunk.constants.count; i++) {
+            gc_mark_value(pGc, function->chunk.constants.values[i]);
+        }
+        break;
+    }
+    case OBJECT_native:
+        break;
+    case OBJECT_class:
+        // Snapshots load classes and instances before what they refer to,
+        // so these may still be NULL.
+        gc_mark_object(pGc, (Object*)((ObjectClass*)object)->name);
+        break;
+    case OBJECT_instance: {
+        ObjectInstance* instance = (ObjectInstance*)object;
+        gc_mark_object(pGc, (Object*)instance->klass);
+        for (uint32_t i = 0; i < instance->shape->field_count; i++) {
+            gc_mark_value(pGc, instance->fields[i]);
+        }
+        return object_size(object) +
+               sizeof(*instance->fields) * instance->field_capacity;
+    }
+    case OBJECT_fiber: {
+        // The running fiber is pushed to without a barrier, so it's also a
+        // root, and it's grayed again when it stops running.
+        ObjectFiber* fiber = (ObjectFiber*)object;
+        for (Value* slot = fiber->stack; slot < fiber->stack_top; slot++) {
+            gc_mark_value(pGc, *slot);
+        }
+        for (int i = 0; i < fiber->frame_count; i++) {
+            gc_mark_object(pGc, (Object*)fiber->frames[i].function);
+        }
+        gc_mark_object(pGc, (Object*)fiber->caller);
+        gc_mark_object(pGc, (Object*)fiber->next_ready);
+        size_t const depth = (size_t)(fiber->stack_top - fiber->stack);
+        return object_size(object) + sizeof(*fiber->stack) * depth;
+    }
+    }
+    return object_size(object);
+}
+
+static void scan_roots(GarbageCollector* pGc) {
+    if (pGc->mark_roots != NULL) {
+        pGc->mark_roots(pGc, pGc->roots_context);
+    }
+}
+
+static void start_cycle(GarbageCollector* pGc) {
+    pGc->phase = GC_PHASE_mark;
+    scan_roots(pGc);
+}
+
+static void finish_marking(GarbageCollector* pGc) {
+    // Roots are not guarded by the write barrier, so they are scanned once
+    // more. This pause is bounded by the size of the roots and by whatever
+    // the mutator made reachable from them since the cycle started, not by
+    // the size of the heap.
+    scan_roots(pGc);
+    while (pGc->gray_count > 0) {
+        pGc->gray_count -= 1;
+        blacken(pGc, pGc->gray[pGc->gray_count]);
+    }
+    // Everything still carrying the old white is unreachable.
+    pGc->white ^= 1;
+    pGc->phase = GC_PHASE_sweep;
+    pGc->sweep = &pGc->objects;
+}
+
+static void finish_cycle(GarbageCollector* pGc) {
+    pGc->phase = GC_PHASE_idle;
+    pGc->sweep = NULL;
+    pGc->stats.cycles += 1;
+    double const next_gc = (double)pGc->bytes_live * pGc->growth_factor;
+    pGc->next_gc =
+        next_gc < CLOX_GC_MIN_HEAP ? CLOX_GC_MIN_HEAP : (size_t)next_gc;
+}
+
+static size_t propagate(GarbageCollector* pGc, size_t const budget) {
+    size_t work = 0;
+    while (pGc->gray_count > 0 && work < budget) {
+        pGc->gray_count -= 1;
+        work += blacken(pGc, pGc->gray[pGc->gray_count]);
+    }
+    if (pGc->gray_count == 0) {
+        finish_marking(pGc);
+    }
+    return work;
+}
+
+static size_t sweep(GarbageCollector* pGc, size_t const budget) {
+    uint8_t const dead = pGc->white ^ 1;
+    size_t work = 0;
+    while (*pGc->sweep != NULL && work < budget) {
+        Object* object = *pGc->sweep;
+        work += object_size(object);
+        if (object->color == dead) {
+            *pGc->sweep = object->next;
+            object_free(pGc, object);
+        } else {
+            object->color = pGc->white;
+            pGc->sweep = &object->next;
+        }
+    }
+    if (*pGc->sweep == NULL) {
+        finish_cycle(pGc);
+    }
+    return work;
+}
+
+// Advances the current cycle by at most `budget` bytes of work.
+static void advance(GarbageCollector* pGc, size_t budget) {
+    while (budget > 0 && pGc->phase != GC_PHASE_idle) {
+        size_t const work = (pGc->phase == GC_PHASE_mark
+                                 ? propagate(pGc, budget)
+                                 : sweep(pGc, budget));
+        budget = work >= budget ? 0 : budget - work;
+    }
+}
+
+static void step(GarbageCollector* pGc) {
+    uint64_t const start = now_ns();
+    if (pGc->phase == GC_PHASE_idle) {
+        start_cycle(pGc);
+    }
+    // The collector is paced by the mutator: each step does work in
+    // proportion to what was allocated since the last one, so a cycle
+    // completes before the heap outgrows its threshold by much.
+    size_t const debt =
+        pGc->debt < CLOX_GC_STEP_SIZE ? CLOX_GC_STEP_SIZE : pGc->debt;
+    pGc->debt = 0;
+    advance(pGc, debt * CLOX_GC_STEP_MULTIPLIER);
+    record_pause(pGc, start);
+}
+
+GarbageCollector gc_new(Allocator* pAllocator, GcMarkRootsFn mark_roots,
+                        void* roots_context) {
+    assert(pAllocator != NULL);
+    return (GarbageCollector){.allocator = pAllocator,
+                              .objects = NULL,
+                              .bytes_live = 0,
+                              .next_gc = CLOX_GC_MIN_HEAP,
+                              .debt = 0,
+                              .growth_factor = CLOX_GC_DEFAULT_GROWTH_FACTOR,
+                              .phase = GC_PHASE_idle,
+                              .white = GC_COLOR_white0,
+                              .gray = NULL,
+                              .gray_count = 0,
+                              .gray_capacity = 0,
+                              .sweep = NULL,
+                              .mark_roots = mark_roots,
+                              .roots_context = roots_context,
+                              .stats = {0},
+                              .strings = intern_table_new_alloc()};
+}
+
+void gc_free(GarbageCollector* pGc) {
+    assert(pGc != NULL);
+    Object* object = pGc->objects;
+    while (object != NULL) {
+        Object* next = object->next;
+        object_free(pGc, object);
+        object = next;
+    }
+    pGc->objects = NULL;
+    pGc->sweep = NULL;
+    pGc->phase = GC_PHASE_idle;
+    intern_table_free(&pGc->strings);
+    pGc->gray = memory_reallocate(MEMORY_heap, pGc->gray,
+                                  sizeof(*pGc->gray) * pGc->gray_capacity, 0);
+    pGc->gray_count = 0;
+    pGc->gray_capacity = 0;
+}
+
+void* gc_reallocate(GarbageCollector* pGc, void* pointer,
+                    size_t const old_size, size_t const new_size) {
+    assert(pGc != NULL);
+    if (new_size > old_size) {
+        size_t const grown = new_size - old_size;
+        pGc->bytes_live += grown;
+        pGc->stats.bytes_allocated += grown;
+        if (pGc->phase != GC_PHASE_idle) {
+            pGc->debt += grown;
+        }
+#ifdef CLOX_DEBUG_STRESS_GC
+        bool const due = true;
+#else
+        bool const due = (pGc->phase == GC_PHASE_idle
+                              ? pGc->bytes_live > pGc->next_gc
+                              : pGc->debt >= CLOX_GC_STEP_SIZE);
+#endif
+        if (due) {
+            step(pGc);
+        }
+    } else {
+        size_t const shrunk = old_size - new_size;
+        pGc->bytes_live -= shrunk;
+        pGc->stats.bytes_freed += shrunk;
+    }
+
+    return allocator_reallocate(pGc->allocator, pointer, old_size, new_size);
+}
+
+void gc_link_object(GarbageCollector* pGc, Object* object) {
+    assert(pGc != NULL);
+    assert(object != NULL);
+    object->color = pGc->white;
+    object->next = pGc->objects;
+    pGc->objects = object;
+}
+
+void gc_mark_object(GarbageCollector* pGc, Object* object) {
+    assert(pGc != NULL);
+    if (object == NULL || !is_white(object)) {
+        return;
+    }
+    object->color = GC_COLOR_gray;
+    push_gray(pGc, object);
+}
+
+void gc_mark_value(GarbageCollector* pGc, Value const value) {
+    if (VALUE_IS_OBJECT(value)) {
+        gc_mark_object(pGc, VALUE_AS_OBJECT(value));
+    }
+}
+
+void gc_barrier_slow(GarbageCollector* pGc, Object* child) {
+    gc_mark_object(pGc, child);
+}
+
+void gc_barrier_back(GarbageCollector* pGc, Object* object) {
+    assert(pGc != NULL);
+    if (pGc->phase == GC_PHASE_mark && object->color == GC_COLOR_black) {
+        object->color = GC_COLOR_gray;
+        push_gray(pGc, object);
+    }
+}
+
+void gc_revive(GarbageCollector* pGc, Object* object) {
+    assert(pGc != NULL);
+    switch (pGc->phase) {
+    case GC_PHASE_idle:
+        break;
+    case GC_PHASE_mark:
+        gc_mark_object(pGc, object);
+        break;
+    case GC_PHASE_sweep:
+        // Found dead but not swept yet. Once swept it's no longer interned,
+        // so this is the only case where it would be handed out freed.
+        if (object->color == (pGc->white ^ 1)) {
+            object->color = pGc->white;
+        }
+        break;
+    }
+}
+
+void gc_collect(GarbageCollector* pGc) {
+    assert(pGc != NULL);
+    uint64_t const start = now_ns();
+    // Objects that died after an in-flight cycle took its root snapshot may
+    // survive it, so that cycle is finished before running a complete one.
+    if (pGc->phase != GC_PHASE_idle) {
+        advance(pGc, SIZE_MAX);
+    }
+    start_cycle(pGc);
+    advance(pGc, SIZE_MAX);
+    pGc->debt = 0;
+    record_pause(pGc, start);
+}
+
+void gc_set_growth_factor(GarbageCollector* pGc, double const growth_factor) {
+    assert(pGc != NULL);
+    assert(growth_factor > 1.0);
+    pGc->growth_factor = growth_factor;
+}
+
+GcStats gc_stats(GarbageCollector const* pGc) {
+    assert(pGc != NULL);
+    return pGc->stats;
+}
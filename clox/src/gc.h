@@ -0,0 +1,121 @@
+#ifndef CLOX_GC_H
+#define CLOX_GC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h" // Allocator
+#include "intern.h"    // InternTable
+#include "object.h"    // Object
+#include "value.h"     // Value
+
+// Heap size the first collection cycle starts at.
+#define CLOX_GC_MIN_HEAP (1024 * 1024)
+// Live heap size is multiplied by this factor to pick the next cycle start.
+#define CLOX_GC_DEFAULT_GROWTH_FACTOR 2.0
+// Bytes the mutator may allocate before it has to pay for a collector step.
+#define CLOX_GC_STEP_SIZE (8 * 1024)
+// Bytes of collector work done for each byte the mutator allocated.
+#define CLOX_GC_STEP_MULTIPLIER 2
+
+// Tri-color marking with two whites. The current white is flipped at the end
+// of marking, so objects born while sweeping already have the "live" white
+// and are not mistaken for garbage by the sweep that is in progress.
+typedef enum {
+    GC_COLOR_white0,
+    GC_COLOR_white1,
+    GC_COLOR_gray,
+    GC_COLOR_black
+} GcColor;
+
+typedef enum {
+    GC_PHASE_idle,
+    GC_PHASE_mark,
+    GC_PHASE_sweep
+} GcPhase;
+
+typedef struct {
+    size_t cycles;
+    size_t steps;
+    size_t bytes_allocated;
+    size_t bytes_freed;
+    uint64_t pause_last_ns;
+    uint64_t pause_max_ns;
+    uint64_t pause_total_ns;
+} GcStats;
+
+typedef struct GarbageCollector GarbageCollector;
+
+// Called at the start of a cycle and again right before sweeping to gray
+// every root with gc_mark_value()/gc_mark_object().
+typedef void (*GcMarkRootsFn)(GarbageCollector* pGc, void* context);
+
+struct GarbageCollector {
+    Allocator* allocator;
+    Object* objects;
+    size_t bytes_live;
+    size_t next_gc;
+    size_t debt;
+    double growth_factor;
+    GcPhase phase;
+    uint8_t white;
+    Object** gray;
+    size_t gray_count;
+    size_t gray_capacity;
+    Object** sweep;
+    GcMarkRootsFn mark_roots;
+    void* roots_context;
+    GcStats stats;
+    // Weak, strings are removed as they're freed.
+    InternTable strings;
+};
+
+// Object memory is carved from `pAllocator`, which must outlive the
+// collector.
+GarbageCollector gc_new(Allocator* pAllocator, GcMarkRootsFn mark_roots,
+                        void* roots_context);
+
+void gc_free(GarbageCollector* pGc);
+
+// Single entry point for heap object memory: accounts for the bytes, pays
+// for collector work and then hands the request to the allocator.
+void* gc_reallocate(GarbageCollector* pGc, void* pointer,
+                    size_t const old_size, size_t const new_size);
+
+void gc_link_object(GarbageCollector* pGc, Object* object);
+
+void gc_mark_object(GarbageCollector* pGc, Object* object);
+
+void gc_mark_value(GarbageCollector* pGc, Value const value);
+
+// Keeps `object` alive although it may not have been reached, for the
+// intern table which hands out strings it doesn't hold on to.
+void gc_revive(GarbageCollector* pGc, Object* object);
+
+void gc_collect(GarbageCollector* pGc);
+
+void gc_set_growth_factor(GarbageCollector* pGc, double const growth_factor);
+
+GcStats gc_stats(GarbageCollector const* pGc);
+
+void gc_barrier_slow(GarbageCollector* pGc, Object* child);
+
+// Must be called whenever `child` is stored into a field of `parent`. While
+// marking, a black object may never point to a white one, so the child is
+// grayed (Dijkstra-style insertion barrier). Outside of marking this is a
+// single compare.
+static inline void gc_write_barrier(GarbageCollector* pGc, Object* parent,
+                                    Value const child) {
+    if (pGc->phase == GC_PHASE_mark && parent->color == GC_COLOR_black &&
+        VALUE_IS_OBJECT(child)) {
+        gc_barrier_slow(pGc, VALUE_AS_OBJECT(child));
+    }
+}
+
+// For objects that are changed in bulk without a write barrier per store:
+// grays `object` again, so that it's rescanned as a whole if it had been
+// scanned already.
+void gc_barrier_back(GarbageCollector* pGc, Object* object);
+
+#endif // !CLOX_GC_H
@@ -0,0 +1,131 @@
+#include "global.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "memory.h" // memory_*
+#include "value.h"  // Value, VALUE_*
+
+// FNV-1a.
+static uint32_t hash_name(char const* name, int const length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+// Returns the bucket holding `name` or the empty bucket it belongs in.
+static uint32_t* find_bucket(GlobalTable const* pGlobals, char const* name,
+                             int const length, uint32_t const hash) {
+    size_t const mask = pGlobals->bucket_capacity - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+        uint32_t* bucket = &pGlobals->buckets[index];
+        if (*bucket == 0) {
+            return bucket;
+        }
+        GlobalName const* entry = &pGlobals->names[*bucket - 1];
+        if (entry->hash == hash && entry->length == length &&
+            memcmp(entry->chars, name, length) == 0) {
+            return bucket;
+        }
+    }
+}
+
+static uint32_t* allocate_buckets(size_t const capacity) {
+    uint32_t* buckets =
+        memory_reallocate(MEMORY_globals, NULL, 0, sizeof(*buckets) * capacity);
+    memset(buckets, 0, sizeof(*buckets) * capacity);
+    return buckets;
+}
+
+static void grow_buckets(GlobalTable* pGlobals) {
+    memory_reallocate(MEMORY_globals, pGlobals->buckets,
+                      sizeof(*pGlobals->buckets) * pGlobals->bucket_capacity,
+                      0);
+    pGlobals->bucket_capacity *= 2;
+    pGlobals->buckets = allocate_buckets(pGlobals->bucket_capacity);
+    for (size_t slot = 0; slot < pGlobals->count; slot++) {
+        GlobalName const* name = &pGlobals->names[slot];
+        *find_bucket(pGlobals, name->chars, name->length, name->hash) =
+            (uint32_t)slot + 1;
+    }
+}
+
+static void grow_slots(GlobalTable* pGlobals) {
+    size_t const capacity = pGlobals->capacity * 2;
+    pGlobals->names = memory_reallocate(
+        MEMORY_globals, pGlobals->names,
+        sizeof(*pGlobals->names) * pGlobals->capacity,
+        sizeof(*pGlobals->names) * capacity);
+    pGlobals->values = memory_reallocate(
+        MEMORY_globals, pGlobals->values,
+        sizeof(*pGlobals->values) * pGlobals->capacity,
+        sizeof(*pGlobals->values) * capacity);
+    pGlobals->capacity = capacity;
+}
+
+GlobalTable global_table_new_alloc(void) {
+    GlobalName* names =
+        memory_reallocate(MEMORY_globals, NULL, 0,
+                          sizeof(*names) * CLOX_GLOBAL_TABLE_MIN_CAPACITY);
+    Value* values =
+        memory_reallocate(MEMORY_globals, NULL, 0,
+                          sizeof(*values) * CLOX_GLOBAL_TABLE_MIN_CAPACITY);
+    // Twice as many buckets as slots keeps the load factor at most 1/2.
+    uint32_t* buckets = allocate_buckets(CLOX_GLOBAL_TABLE_MIN_CAPACITY * 2);
+    return (GlobalTable){.names = names,
+                         .values = values,
+                         .count = 0,
+                         .capacity = CLOX_GLOBAL_TABLE_MIN_CAPACITY,
+                         .buckets = buckets,
+                         .bucket_capacity = CLOX_GLOBAL_TABLE_MIN_CAPACITY * 2};
+}
+
+void global_table_free(GlobalTable* pGlobals) {
+    assert(pGlobals != NULL);
+    for (size_t slot = 0; slot < pGlobals->count; slot++) {
+        GlobalName const* name = &pGlobals->names[slot];
+        memory_reallocate(MEMORY_globals, name->chars, name->length + 1, 0);
+    }
+    pGlobals->names = memory_reallocate(
+        MEMORY_globals, pGlobals->names,
+        sizeof(*pGlobals->names) * pGlobals->capacity, 0);
+    pGlobals->values = memory_reallocate(
+        MEMORY_globals, pGlobals->values,
+        sizeof(*pGlobals->values) * pGlobals->capacity, 0);
+    pGlobals->buckets = memory_reallocate(
+        MEMORY_globals, pGlobals->buckets,
+        sizeof(*pGlobals->buckets) * pGlobals->bucket_capacity, 0);
+    pGlobals->count = 0;
+}
+
+size_t global_table_resolve(GlobalTable* pGlobals, char const* name,
+                            int const length) {
+    assert(pGlobals != NULL);
+    uint32_t const hash = hash_name(name, length);
+    uint32_t* bucket = find_bucket(pGlobals, name, length, hash);
+    if (*bucket != 0) {
+        return *bucket - 1;
+    }
+
+    if (pGlobals->count >= pGlobals->capacity) {
+        grow_slots(pGlobals);
+    }
+    size_t const slot = pGlobals->count;
+    char* chars = memory_reallocate(MEMORY_globals, NULL, 0, length + 1);
+    memcpy(chars, name, length);
+    chars[length] = '\0';
+    pGlobals->names[slot] =
+        (GlobalName){.chars = chars, .length = length, .hash = hash};
+    pGlobals->values[slot] = VALUE_UNDEFINED;
+    pGlobals->count += 1;
+    *bucket = (uint32_t)slot + 1;
+    if (pGlobals->count * 2 > pGlobals->bucket_capacity) {
+        grow_buckets(pGlobals);
+    }
+    return slot;
+}
@@ -0,0 +1,40 @@
+#ifndef CLOX_GLOBAL_H
+#define CLOX_GLOBAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "value.h" // Value
+
+#define CLOX_GLOBAL_TABLE_MIN_CAPACITY 8
+// Global slots are encoded as a 16-bit operand.
+#define CLOX_GLOBAL_MAX (UINT16_MAX + 1)
+
+typedef struct {
+    char* chars;
+    int length;
+    uint32_t hash;
+} GlobalName;
+
+// Global variables of a VM. The compiler resolves every global name to a
+// dense slot once, so the interpreter only ever indexes `values`. Slots of
+// names that were mentioned but never defined hold VALUE_undefined.
+typedef struct {
+    GlobalName* names;
+    Value* values;
+    size_t count;
+    size_t capacity;
+    // Open addressing table from name to slot + 1, 0 marks an empty bucket.
+    uint32_t* buckets;
+    size_t bucket_capacity;
+} GlobalTable;
+
+GlobalTable global_table_new_alloc(void) __attribute__((warn_unused_result));
+
+void global_table_free(GlobalTable* pGlobals);
+
+// Returns the slot of `name`, adding an undefined slot if it's new.
+size_t global_table_resolve(GlobalTable* pGlobals, char const* name,
+                            int const length);
+
+#endif // !CLOX_GLOBAL_H
@@ -0,0 +1,116 @@
+#include "intern.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "memory.h" // memory_*
+#include "object.h" // ObjectString
+
+static ObjectString** allocate_buckets(size_t const capacity) {
+    ObjectString** buckets =
+        memory_reallocate(MEMORY_heap, NULL, 0, sizeof(*buckets) * capacity);
+    for (size_t i = 0; i < capacity; i++) {
+        buckets[i] = NULL;
+    }
+    return buckets;
+}
+
+static void insert(InternTable* pTable, ObjectString* string) {
+    size_t const mask = pTable->capacity - 1;
+    size_t index = string->hash & mask;
+    while (pTable->buckets[index] != NULL) {
+        index = (index + 1) & mask;
+    }
+    pTable->buckets[index] = string;
+}
+
+static void grow(InternTable* pTable) {
+    ObjectString** old = pTable->buckets;
+    size_t const old_capacity = pTable->capacity;
+    pTable->capacity *= 2;
+    pTable->buckets = allocate_buckets(pTable->capacity);
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i] != NULL) {
+            insert(pTable, old[i]);
+        }
+    }
+    memory_reallocate(MEMORY_heap, old, sizeof(*old) * old_capacity, 0);
+}
+
+InternTable intern_table_new_alloc(void) {
+    return (InternTable){
+        .buckets = allocate_buckets(CLOX_INTERN_TABLE_MIN_CAPACITY),
+        .count = 0,
+        .capacity = CLOX_INTERN_TABLE_MIN_CAPACITY};
+}
+
+void intern_table_free(InternTable* pTable) {
+    assert(pTable != NULL);
+    pTable->buckets =
+        memory_reallocate(MEMORY_heap, pTable->buckets,
+                          sizeof(*pTable->buckets) * pTable->capacity, 0);
+    pTable->count = 0;
+    pTable->capacity = 0;
+}
+
+uint32_t intern_hash(char const* chars, size_t const length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)chars[i];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+ObjectString* intern_table_find(InternTable const* pTable, char const* chars,
+                                size_t const length, uint32_t const hash) {
+    assert(pTable != NULL);
+    size_t const mask = pTable->capacity - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+        ObjectString* string = pTable->buckets[index];
+        if (string == NULL) {
+            return NULL;
+        }
+        if (string->hash == hash && string->length == length &&
+            memcmp(string->chars, chars, length) == 0) {
+            return string;
+        }
+    }
+}
+
+void intern_table_add(InternTable* pTable, ObjectString* string) {
+    assert(pTable != NULL);
+    assert(string != NULL);
+    // Keeps the load factor at most 1/2.
+    if ((pTable->count + 1) * 2 > pTable->capacity) {
+        grow(pTable);
+    }
+    insert(pTable, string);
+    pTable->count += 1;
+}
+
+void intern_table_remove(InternTable* pTable, ObjectString const* string) {
+    assert(pTable != NULL);
+    size_t const mask = pTable->capacity - 1;
+    size_t index = string->hash & mask;
+    while (pTable->buckets[index] != string) {
+        assert(pTable->buckets[index] != NULL);
+        index = (index + 1) & mask;
+    }
+    // Shifts the rest of the probe run back instead of leaving a tombstone,
+    // so lookups never have to skip over removed strings.
+    size_t hole = index;
+    for (size_t next = (hole + 1) & mask; pTable->buckets[next] != NULL;
+         next = (next + 1) & mask) {
+        size_t const home = pTable->buckets[next]->hash & mask;
+        // Moves the entry unless its home lies cyclically in (hole, next].
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            pTable->buckets[hole] = pTable->buckets[next];
+            hole = next;
+        }
+    }
+    pTable->buckets[hole] = NULL;
+    pTable->count -= 1;
+}
@@ -0,0 +1,36 @@
+#ifndef CLOX_INTERN_H
+#define CLOX_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "object.h" // ObjectString
+
+#define CLOX_INTERN_TABLE_MIN_CAPACITY 64
+
+// Every live string of a heap, so that equal strings are the same object
+// and can be compared by pointer. The table doesn't keep its strings alive,
+// the collector removes them as it frees them.
+typedef struct {
+    // Open addressing with linear probing, NULL marks an empty bucket.
+    ObjectString** buckets;
+    size_t count;
+    size_t capacity;
+} InternTable;
+
+InternTable intern_table_new_alloc(void) __attribute__((warn_unused_result));
+
+void intern_table_free(InternTable* pTable);
+
+// FNV-1a.
+uint32_t intern_hash(char const* chars, size_t const length);
+
+// Returns the string equal to `chars`, or NULL.
+ObjectString* intern_table_find(InternTable const* pTable, char const* chars,
+                                size_t const length, uint32_t const hash);
+
+void intern_table_add(InternTable* pTable, ObjectString* string);
+
+void intern_table_remove(InternTable* pTable, ObjectString const* string);
+
+#endif // !CLOX_INTERN_H
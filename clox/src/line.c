@@ -2,11 +2,13 @@
 
 #include <assert.h>
 #include <stdio.h>
-#include <stdlib.h>
+
+#include "memory.h" // memory_*
 
 LineVector line_vector_new_alloc(void) {
-    LineInfo* lines = malloc(sizeof(*lines) * CLOX_LINE_VECTOR_MIN_CAPACITY);
-    assert(lines != NULL);
+    LineInfo* lines =
+        memory_reallocate(MEMORY_lines, NULL, 0,
+                          sizeof(*lines) * CLOX_LINE_VECTOR_MIN_CAPACITY);
     return (LineVector){
         .lines = lines, .capacity = CLOX_LINE_VECTOR_MIN_CAPACITY, .count = 0};
 }
@@ -14,8 +16,9 @@ LineVector line_vector_new_alloc(void) {
 void line_vector_free(LineVector* pLineVector) {
     assert(pLineVector != NULL);
     assert(pLineVector->lines != NULL);
-    free(pLineVector->lines);
-    pLineVector->lines = NULL;
+    pLineVector->lines = memory_reallocate(
+        MEMORY_lines, pLineVector->lines,
+        sizeof(*pLineVector->lines) * pLineVector->capacity, 0);
 }
 
 LineVector line_vector_push(LineVector const line_vector,
@@ -28,9 +31,10 @@ LineVector line_vector_push(LineVector const line_vector,
         new_capacity = (line_vector.capacity < CLOX_LINE_VECTOR_MIN_CAPACITY
                             ? CLOX_LINE_VECTOR_MIN_CAPACITY
                             : line_vector.capacity * 2);
-        new_lines = realloc(line_vector.lines,
-                            sizeof(*line_vector.lines) * new_capacity);
-        assert(new_lines != NULL);
+        new_lines = memory_reallocate(
+            MEMORY_lines, line_vector.lines,
+            sizeof(*line_vector.lines) * line_vector.capacity,
+            sizeof(*line_vector.lines) * new_capacity);
     }
     new_lines[line_vector.count] = line_info;
     return (LineVector){.lines = new_lines,
@@ -38,6 +42,19 @@ LineVector line_vector_push(LineVector const line_vector,
                         .count = line_vector.count + 1};
 }
 
+LineVector line_vector_shrink(LineVector const line_vector) {
+    assert(line_vector.lines != NULL);
+    if (line_vector.count == 0 || line_vector.count == line_vector.capacity) {
+        return line_vector;
+    }
+    LineInfo* lines = memory_reallocate(
+        MEMORY_lines, line_vector.lines,
+        sizeof(*line_vector.lines) * line_vector.capacity,
+        sizeof(*line_vector.lines) * line_vector.count);
+    return (LineVector){
+        .lines = lines, .capacity = line_vector.count, .count = line_vector.count};
+}
+
 int line_vector_get_line(LineVector const line_vector,
                          size_t const instruction) {
     size_t start = 0;
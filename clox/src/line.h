@@ -24,6 +24,10 @@ LineVector line_vector_push(LineVector const line_vector,
                             LineInfo const line_info)
     __attribute__((warn_unused_result));
 
+// Gives back the unused capacity.
+LineVector line_vector_shrink(LineVector const line_vector)
+    __attribute__((warn_unused_result));
+
 int line_vector_get_line(LineVector const line_vector,
                          size_t const instruction);
 
@@ -1,69 +1,395 @@
-#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include "chunk.h" // Chunk, chunk_*
-#include "vm.h"    // vm_*
+#include "batch.h"    // BatchColumn
+#include "cache.h"    // ChunkCacheStats, chunk_cache_*
+#include "memory.h"   // memory_*
+#include "output.h"   // output_*
+#include "scanner.h"  // CLOX_SCANNER_PARALLEL_MIN_SIZE
+#include "snapshot.h" // snapshot_*
+#include "vm.h"       // VirtualMachine, vm_*
 
-#define MAX_LINE_SIZE 1024
+#define MIN_LINE_CAPACITY 1024
+#define MIN_CELL_CAPACITY 1024
+// Separate the fields of a batch's table.
+#define FIELD_SEPARATORS " \t\r\n"
 
-static void repl(void) {
-    char line[MAX_LINE_SIZE];
+// Reads a whole line however long it is, growing `*pLine` as needed.
+static bool read_line(char** pLine, size_t* pCapacity) {
+    size_t length = 0;
+    for (;;) {
+        if (*pCapacity - length < 2) {
+            size_t const capacity = *pCapacity < MIN_LINE_CAPACITY
+                                        ? MIN_LINE_CAPACITY
+                                        : *pCapacity * 2;
+            *pLine =
+                memory_reallocate(MEMORY_source, *pLine, *pCapacity, capacity);
+            *pCapacity = capacity;
+        }
+        if (!fgets(*pLine + length, (int)(*pCapacity - length), stdin)) {
+            return length > 0;
+        }
+        length += strlen(*pLine + length);
+        if ((*pLine)[length - 1] == '\n') {
+            return true;
+        }
+    }
+}
+
+static void repl(VirtualMachine* pVm) {
+    char* line = NULL;
+    size_t capacity = 0;
     for (;;) {
         printf("> ");
-        if (!fgets(line, sizeof(line), stdin)) {
+        // The VM writes to the descriptor directly, around stdio.
+        fflush(stdout);
+        if (!read_line(&line, &capacity)) {
             printf("\n");
             break;
         }
-        vm_interpret(line);
+        if (vm_interpret_cached(pVm, line) == INTERPRET_SUSPENDED) {
+            fprintf(stderr, "Ran out of budget.\n");
+            vm_cancel(pVm);
+        }
     }
+    memory_reallocate(MEMORY_source, line, capacity, 0);
 }
 
-static char* read_file(char const* const path) {
-    FILE* file = fopen(path, "rb");
-    if (file == NULL) {
-        fprintf(stderr, "Could not open file \"%s\"\n", path);
-        exit(74);
+static bool is_command(char const* line, char const* command) {
+    size_t const length = strlen(command);
+    return strncmp(line, command, length) == 0 &&
+           (line[length] == '\0' || strcmp(line + length, "\n") == 0);
+}
+
+static void print_status(InterpretResult const result) {
+    switch (result) {
+    case INTERPRET_OK:
+        printf("#ok\n");
+        break;
+    case INTERPRET_COMPILE_ERROR:
+        printf("#compile-error\n");
+        break;
+    case INTERPRET_RUNTIME_ERROR:
+        printf("#runtime-error\n");
+        break;
+    case INTERPRET_SUSPENDED:
+        printf("#suspended\n");
+        break;
     }
+}
 
-    fseek(file, 0, SEEK_END);
-    size_t file_size = ftell(file);
-    rewind(file);
+// Every line of standard input is a program. Its output is followed by a
+// status line starting with '#', which can't start a line of Lox, so that
+// clients know where a response ends. "#stats" reports the chunk cache. A
+// program that runs out of budget ends with "#suspended", "#resume" runs it
+// on with a new budget and the next program drops it.
+static void serve(VirtualMachine* pVm) {
+    char* line = NULL;
+    size_t capacity = 0;
+    while (read_line(&line, &capacity)) {
+        if (is_command(line, "#stats")) {
+            ChunkCacheStats const stats = chunk_cache_stats(&pVm->cache);
+            printf("#stats hits=%zu misses=%zu evictions=%zu\n", stats.hits,
+                   stats.misses, stats.evictions);
+        } else if (is_command(line, "#resume")) {
+            if (pVm->suspended) {
+                print_status(vm_resume(pVm));
+            } else {
+                printf("#not-suspended\n");
+            }
+        } else {
+            if (pVm->suspended) {
+                vm_cancel(pVm);
+            }
+            print_status(vm_interpret_cached(pVm, line));
+        }
+        fflush(stdout);
+    }
+    memory_reallocate(MEMORY_source, line, capacity, 0);
+}
 
-    char* buffer = (char*)malloc(file_size + 1);
-    assert(buffer != NULL);
+static char* copy_string(char const* string) {
+    size_t const size = strlen(string) + 1;
+    char* copy = memory_reallocate(MEMORY_source, NULL, 0, size);
+    memcpy(copy, string, size);
+    return copy;
+}
 
-    size_t bytes_read = fread(buffer, sizeof(char), file_size, file);
-    assert(bytes_read == file_size);
+// Reads the rest of a table in rows of `column_count` numbers into `*pCells`,
+// row after row. Returns the number of rows, or SIZE_MAX after reporting a
+// malformed one. Blank lines are skipped.
+static size_t read_rows(char** pLine, size_t* pLineCapacity,
+                        size_t const column_count, double** pCells,
+                        size_t* pCellCapacity) {
+    size_t rows = 0;
+    while (read_line(pLine, pLineCapacity)) {
+        size_t fields = 0;
+        bool malformed = false;
+        for (char* field = strtok(*pLine, FIELD_SEPARATORS); field != NULL;
+             field = strtok(NULL, FIELD_SEPARATORS)) {
+            char* end;
+            double const value = strtod(field, &end);
+            if (*end != '\0' || fields == column_count) {
+                malformed = true;
+                break;
+            }
+            size_t const cell = rows * column_count + fields;
+            if (cell == *pCellCapacity) {
+                size_t const capacity = *pCellCapacity < MIN_CELL_CAPACITY
+                                            ? MIN_CELL_CAPACITY
+                                            : *pCellCapacity * 2;
+                *pCells = memory_reallocate(MEMORY_source, *pCells,
+                                            sizeof(**pCells) * *pCellCapacity,
+                                            sizeof(**pCells) * capacity);
+                *pCellCapacity = capacity;
+            }
+            (*pCells)[cell] = value;
+            fields += 1;
+        }
+        if (fields == 0 && !malformed) {
+            continue;
+        }
+        if (malformed || fields != column_count) {
+            fprintf(stderr, "Row %zu must have a number per column.\n",
+                    rows + 1);
+            return SIZE_MAX;
+        }
+        rows += 1;
+    }
+    return rows;
+}
 
-    buffer[bytes_read] = '\0';
+// Evaluates `expression` once per row of the table on standard input and
+// prints one result per row. The first line of the table names the columns,
+// the globals the expression reads, and every other line has a number per
+// column.
+static int run_batch(VirtualMachine* pVm, char const* expression) {
+    char* line = NULL;
+    size_t line_capacity = 0;
+    char** names = NULL;
+    size_t column_count = 0;
+    size_t names_capacity = 0;
+    if (read_line(&line, &line_capacity)) {
+        for (char* name = strtok(line, FIELD_SEPARATORS); name != NULL;
+             name = strtok(NULL, FIELD_SEPARATORS)) {
+            if (column_count == names_capacity) {
+                size_t const capacity =
+                    names_capacity < 8 ? 8 : names_capacity * 2;
+                names = memory_reallocate(MEMORY_source, names,
+                                          sizeof(*names) * names_capacity,
+                                          sizeof(*names) * capacity);
+                names_capacity = capacity;
+            }
+            names[column_count] = copy_string(name);
+            column_count += 1;
+        }
+    }
+    double* cells = NULL;
+    size_t cell_capacity = 0;
+    size_t const rows = read_rows(&line, &line_capacity, column_count,
+                                  &cells, &cell_capacity);
+    memory_reallocate(MEMORY_source, line, line_capacity, 0);
 
-    fclose(file);
-    return buffer;
+    int status = 65;
+    if (rows != SIZE_MAX) {
+        // Rows were read one after the other, the batch wants each column
+        // in one piece. There's room for a row more, so that no column or
+        // result is NULL even for an empty table, NULL marks an unbound
+        // global.
+        size_t const cell_count = (rows + 1) * column_count;
+        double* values = memory_reallocate(MEMORY_source, NULL, 0,
+                                           sizeof(*values) * cell_count);
+        BatchColumn* columns = memory_reallocate(
+            MEMORY_source, NULL, 0, sizeof(*columns) * column_count);
+        for (size_t column = 0; column < column_count; column++) {
+            for (size_t row = 0; row < rows; row++) {
+                values[column * rows + row] =
+                    cells[row * column_count + column];
+            }
+            columns[column] = (BatchColumn){.name = names[column],
+                                            .values = &values[column * rows]};
+        }
+        double* results = memory_reallocate(MEMORY_source, NULL, 0,
+                                            sizeof(*results) * (rows + 1));
+        InterpretResult const result = vm_evaluate_batch(
+            pVm, expression, columns, column_count, rows, results);
+        if (result == INTERPRET_OK) {
+            for (size_t row = 0; row < rows; row++) {
+                output_write_number(&pVm->output, results[row]);
+                output_write_char(&pVm->output, '\n');
+            }
+            output_flush(&pVm->output);
+        }
+        status = result == INTERPRET_OK              ? 0
+                 : result == INTERPRET_COMPILE_ERROR ? 65
+                                                     : 70;
+        memory_reallocate(MEMORY_source, results,
+                          sizeof(*results) * (rows + 1), 0);
+        memory_reallocate(MEMORY_source, columns,
+                          sizeof(*columns) * column_count, 0);
+        memory_reallocate(MEMORY_source, values,
+                          sizeof(*values) * cell_count, 0);
+    }
+
+    memory_reallocate(MEMORY_source, cells, sizeof(*cells) * cell_capacity,
+                      0);
+    for (size_t column = 0; column < column_count; column++) {
+        memory_reallocate(MEMORY_source, names[column],
+                          strlen(names[column]) + 1, 0);
+    }
+    memory_reallocate(MEMORY_source, names, sizeof(*names) * names_capacity,
+                      0);
+    return status;
+}
+
+// Size of a regular file, or -1 for anything that can't seek, like a pipe.
+static long file_size(FILE* file) {
+    if (fseek(file, 0, SEEK_END) != 0) {
+        return -1;
+    }
+    long const size = ftell(file);
+    rewind(file);
+    return size;
+}
+
+// Huge files are read whole and scanned in parallel, the others streamed.
+static InterpretResult interpret_file(VirtualMachine* pVm, FILE* file) {
+    long const size = file_size(file);
+    if (size < CLOX_SCANNER_PARALLEL_MIN_SIZE) {
+        return vm_interpret_stream(pVm, file);
+    }
+    size_t const capacity = (size_t)size + 1;
+    char* source = memory_reallocate(MEMORY_source, NULL, 0, capacity);
+    size_t const length = fread(source, sizeof(char), (size_t)size, file);
+    source[length] = '\0';
+    InterpretResult const result = vm_interpret_parallel(pVm, source, length);
+    memory_reallocate(MEMORY_source, source, capacity, 0);
+    return result;
 }
 
-static void run_file(char const* const path) {
-    char* source = read_file(path);
-    InterpretResult result = vm_interpret(source);
+static int run_file(VirtualMachine* pVm, char const* const path) {
+    // "-" compiles standard input as it arrives, e.g. from a pipe.
+    bool const is_stdin = strcmp(path, "-") == 0;
+    FILE* file = is_stdin ? stdin : fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open file \"%s\"\n", path);
+        return 74;
+    }
 
-    free(source);
-    source = NULL;
+    InterpretResult result =
+        is_stdin ? vm_interpret_stream(pVm, file) : interpret_file(pVm, file);
+    if (!is_stdin) {
+        fclose(file);
+    }
+    if (result == INTERPRET_SUSPENDED) {
+        fprintf(stderr, "Ran out of budget.\n");
+        vm_cancel(pVm);
+    }
 
     if (result == INTERPRET_COMPILE_ERROR)
-        exit(65);
-    if (result == INTERPRET_RUNTIME_ERROR)
-        exit(70);
+        return 65;
+    if (result == INTERPRET_RUNTIME_ERROR || result == INTERPRET_SUSPENDED)
+        return 70;
+    return 0;
+}
+
+// Parses the value of an option like "--max-calls 100".
+static bool parse_limit(char const* text, uint64_t* pLimit) {
+    char* end;
+    errno = 0;
+    unsigned long long const limit = strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || text[0] == '-') {
+        return false;
+    }
+    *pLimit = (uint64_t)limit;
+    return true;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: clox [--mem-stats] [--max-calls N] [--max-ms N] "
+                    "[--snapshot PATH] [--save-snapshot PATH] "
+                    "[--serve | --batch EXPRESSION | path | -]\n");
+    exit(64);
 }
 
 int main(int argc, char* argv[]) {
-    if (argc == 1) {
-        repl();
-    } else if (argc == 2) {
-        run_file(argv[1]);
+    bool mem_stats = false;
+    bool is_server = false;
+    // Evaluated over the table on standard input instead of running Lox.
+    char const* batch = NULL;
+    // Limits of every program, or of every run of it in the server.
+    uint64_t max_calls = 0;
+    uint64_t max_ms = 0;
+    // Snapshot the VM starts from, and the one it's saved to once done.
+    char const* snapshot = NULL;
+    char const* save_snapshot = NULL;
+    for (; argc > 1 && strncmp(argv[1], "--", 2) == 0; argc--, argv++) {
+        if (strcmp(argv[1], "--mem-stats") == 0) {
+            mem_stats = true;
+        } else if (strcmp(argv[1], "--serve") == 0) {
+            is_server = true;
+        } else if (strcmp(argv[1], "--max-calls") == 0 ||
+                   strcmp(argv[1], "--max-ms") == 0) {
+            uint64_t* limit =
+                strcmp(argv[1], "--max-calls") == 0 ? &max_calls : &max_ms;
+            if (argc < 3 || !parse_limit(argv[2], limit)) {
+                usage();
+            }
+            argc--;
+            argv++;
+        } else if (strcmp(argv[1], "--batch") == 0) {
+            if (argc < 3) {
+                usage();
+            }
+            batch = argv[2];
+            argc--;
+            argv++;
+        } else if (strcmp(argv[1], "--snapshot") == 0 ||
+                   strcmp(argv[1], "--save-snapshot") == 0) {
+            if (argc < 3) {
+                usage();
+            }
+            if (strcmp(argv[1], "--snapshot") == 0) {
+                snapshot = argv[2];
+            } else {
+                save_snapshot = argv[2];
+            }
+            argc--;
+            argv++;
+        } else {
+            break;
+        }
+    }
+    if (argc > 2 || ((is_server || batch != NULL) && argc > 1) ||
+        (is_server && batch != NULL)) {
+        usage();
+    }
+    VirtualMachine* vm = vm_new_alloc();
+    vm_set_budget(vm, max_calls, max_ms * 1000000u);
+    int status = 0;
+    if (snapshot != NULL && !snapshot_load(vm, snapshot)) {
+        status = 74;
+    } else if (is_server) {
+        serve(vm);
+    } else if (batch != NULL) {
+        status = run_batch(vm, batch);
+    } else if (argc == 1) {
+        repl(vm);
     } else {
-        fprintf(stderr, "Usage: clox [path]\n");
-        exit(64);
+        status = run_file(vm, argv[1]);
     }
-    return 0;
+    if (status == 0 && save_snapshot != NULL &&
+        !snapshot_save(vm, save_snapshot)) {
+        status = 74;
+    }
+    vm_free(vm);
+    if (mem_stats) {
+        // After the VM is gone, so "current" shows anything that leaked.
+        memory_print_report(stderr);
+    }
+    return status;
 }
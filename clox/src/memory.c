@@ -0,0 +1,109 @@
+#include "memory.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Counters are process wide and updated atomically, allocations may come
+// from several VMs and threads.
+typedef struct {
+    size_t current_bytes;
+    size_t peak_bytes;
+    size_t allocations;
+    size_t frees;
+} Counters;
+
+static Counters counters[CLOX_MEMORY_SUBSYSTEM_COUNT];
+static Counters total;
+
+static char const* const names[CLOX_MEMORY_SUBSYSTEM_COUNT] = {
+    [MEMORY_code] = "code",       [MEMORY_constants] = "constants",
+    [MEMORY_lines] = "lines",     [MEMORY_source] = "source",
+    [MEMORY_heap] = "heap",       [MEMORY_globals] = "globals",
+    [MEMORY_vm] = "vm",
+};
+
+static void raise_peak(size_t* pPeak, size_t const current) {
+    size_t peak = __atomic_load_n(pPeak, __ATOMIC_RELAXED);
+    while (current > peak &&
+           !__atomic_compare_exchange_n(pPeak, &peak, current, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void count(Counters* pCounters, size_t const old_size,
+                  size_t const new_size) {
+    if (old_size == 0 && new_size > 0) {
+        __atomic_fetch_add(&pCounters->allocations, 1, __ATOMIC_RELAXED);
+    } else if (old_size > 0 && new_size == 0) {
+        __atomic_fetch_add(&pCounters->frees, 1, __ATOMIC_RELAXED);
+    }
+    if (new_size >= old_size) {
+        size_t const current =
+            __atomic_add_fetch(&pCounters->current_bytes, new_size - old_size,
+                               __ATOMIC_RELAXED);
+        raise_peak(&pCounters->peak_bytes, current);
+    } else {
+        __atomic_fetch_sub(&pCounters->current_bytes, old_size - new_size,
+                           __ATOMIC_RELAXED);
+    }
+}
+
+void memory_track(MemorySubsystem const subsystem, size_t const old_size,
+                  size_t const new_size) {
+    assert(subsystem < CLOX_MEMORY_SUBSYSTEM_COUNT);
+    count(&counters[subsystem], old_size, new_size);
+    count(&total, old_size, new_size);
+}
+
+void* memory_reallocate(MemorySubsystem const subsystem, void* pointer,
+                        size_t const old_size, size_t const new_size) {
+    assert((pointer == NULL) == (old_size == 0));
+    memory_track(subsystem, old_size, new_size);
+    if (new_size == 0) {
+        free(pointer);
+        return NULL;
+    }
+    void* result = realloc(pointer, new_size);
+    assert(result != NULL);
+    return result;
+}
+
+static MemoryStats load(Counters* pCounters) {
+    return (MemoryStats){
+        .current_bytes =
+            __atomic_load_n(&pCounters->current_bytes, __ATOMIC_RELAXED),
+        .peak_bytes = __atomic_load_n(&pCounters->peak_bytes, __ATOMIC_RELAXED),
+        .allocations =
+            __atomic_load_n(&pCounters->allocations, __ATOMIC_RELAXED),
+        .frees = __atomic_load_n(&pCounters->frees, __ATOMIC_RELAXED)};
+}
+
+MemoryStats memory_stats(MemorySubsystem const subsystem) {
+    assert(subsystem < CLOX_MEMORY_SUBSYSTEM_COUNT);
+    return load(&counters[subsystem]);
+}
+
+MemoryStats memory_total(void) { return load(&total); }
+
+char const* memory_subsystem_name(MemorySubsystem const subsystem) {
+    assert(subsystem < CLOX_MEMORY_SUBSYSTEM_COUNT);
+    return names[subsystem];
+}
+
+void memory_print_report(FILE* file) {
+    fprintf(file, "%-10s %12s %12s %12s %12s\n", "subsystem", "current",
+            "peak", "allocations", "frees");
+    for (int i = 0; i < CLOX_MEMORY_SUBSYSTEM_COUNT; i++) {
+        MemoryStats const stats = memory_stats((MemorySubsystem)i);
+        fprintf(file, "%-10s %12zu %12zu %12zu %12zu\n",
+                memory_subsystem_name((MemorySubsystem)i), stats.current_bytes,
+                stats.peak_bytes, stats.allocations, stats.frees);
+    }
+    MemoryStats const stats = memory_total();
+    fprintf(file, "%-10s %12zu %12zu %12zu %12zu\n", "total",
+            stats.current_bytes, stats.peak_bytes, stats.allocations,
+            stats.frees);
+}
@@ -0,0 +1,52 @@
+#ifndef CLOX_MEMORY_H
+#define CLOX_MEMORY_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// What an allocation is for, so that memory use can be attributed.
+typedef enum {
+    MEMORY_code,
+    MEMORY_constants,
+    MEMORY_lines,
+    // Source text: scanner buffers, REPL lines and copied lexemes.
+    MEMORY_source,
+    // Objects, including the slabs they are carved from, and the
+    // collector's bookkeeping.
+    MEMORY_heap,
+    MEMORY_globals,
+    // Everything else the VM owns, like its own struct and output buffer.
+    MEMORY_vm,
+} MemorySubsystem;
+
+#define CLOX_MEMORY_SUBSYSTEM_COUNT (MEMORY_vm + 1)
+
+typedef struct {
+    size_t current_bytes;
+    size_t peak_bytes;
+    size_t allocations;
+    size_t frees;
+} MemoryStats;
+
+// The single entry point for memory, which is counted per subsystem. A
+// `new_size` of 0 frees `pointer` and returns NULL. Running out of memory is
+// fatal.
+void* memory_reallocate(MemorySubsystem const subsystem, void* pointer,
+                        size_t const old_size, size_t const new_size);
+
+// Counts memory that isn't allocated through memory_reallocate(), like
+// mapped pages.
+void memory_track(MemorySubsystem const subsystem, size_t const old_size,
+                  size_t const new_size);
+
+MemoryStats memory_stats(MemorySubsystem const subsystem);
+
+// Summed over the subsystems, except for the peak which is the peak of the
+// sum.
+MemoryStats memory_total(void);
+
+char const* memory_subsystem_name(MemorySubsystem const subsystem);
+
+void memory_print_report(FILE* file);
+
+#endif // !CLOX_MEMORY_H
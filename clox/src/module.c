@@ -0,0 +1,327 @@
+// For pthreads and sysconf().
+#define _POSIX_C_SOURCE 200112L
+
+#include "module.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "chunk.h"    // chunk_*
+#include "compiler.h" // compiler_*
+#include "gc.h"       // GarbageCollector, gc_*
+#include "global.h"   // GlobalTable, global_table_*
+#include "memory.h"   // memory_*
+#include "object.h"   // ObjectFunction, object_*
+#include "scanner.h"  // Scanner, scanner_*
+#include "token.h"    // Token, TOKEN_*
+
+#define CLOX_MODULE_MIN_CAPACITY 8
+// Threads reading modules at most, however many processors there are.
+#define CLOX_MODULE_MAX_THREADS 64
+
+ModuleTable module_table_new_alloc(void) {
+    return (ModuleTable){.paths = global_table_new_alloc(),
+                         .modules = NULL,
+                         .capacity = 0};
+}
+
+static void drop_source(Module* pModule) {
+    if (pModule->source == NULL) {
+        return;
+    }
+    scanner_free(&pModule->scanner);
+    memory_reallocate(MEMORY_source, pModule->source, pModule->length + 1, 0);
+    pModule->source = NULL;
+    pModule->length = 0;
+}
+
+void module_table_free(ModuleTable* pModules) {
+    assert(pModules != NULL);
+    for (size_t slot = 0; slot < pModules->paths.count; slot++) {
+        drop_source(&pModules->modules[slot]);
+    }
+    memory_reallocate(MEMORY_globals, pModules->modules,
+                      sizeof(*pModules->modules) * pModules->capacity, 0);
+    pModules->modules = NULL;
+    pModules->capacity = 0;
+    global_table_free(&pModules->paths);
+}
+
+size_t module_table_resolve(ModuleTable* pModules, char const* path,
+                            int const length) {
+    assert(pModules != NULL);
+    size_t const count = pModules->paths.count;
+    size_t const slot = global_table_resolve(&pModules->paths, path, length);
+    if (pModules->paths.count == count) {
+        return slot;
+    }
+    if (slot == pModules->capacity) {
+        size_t const capacity = pModules->capacity < CLOX_MODULE_MIN_CAPACITY
+                                    ? CLOX_MODULE_MIN_CAPACITY
+                                    : pModules->capacity * 2;
+        pModules->modules = memory_reallocate(
+            MEMORY_globals, pModules->modules,
+            sizeof(*pModules->modules) * pModules->capacity,
+            sizeof(*pModules->modules) * capacity);
+        pModules->capacity = capacity;
+    }
+    pModules->modules[slot] = (Module){.state = MODULE_new,
+                                       .ran = false,
+                                       .source = NULL,
+                                       .length = 0,
+                                       .function = NULL};
+    return slot;
+}
+
+void module_table_mark(ModuleTable const* pModules, GarbageCollector* pGc) {
+    for (size_t slot = 0; slot < pModules->paths.count; slot++) {
+        Module const* module = &pModules->modules[slot];
+        if (module->function == NULL) {
+            continue;
+        }
+        gc_mark_object(pGc, &module->function->object);
+        // The compiler adds constants to a module's top-level chunk without
+        // barriers, like it does to the VM's chunk, so they're roots until
+        // the module is compiled.
+        if (module->state != MODULE_compiled) {
+            ValueVector const* constants = &module->function->chunk.constants;
+            for (size_t i = 0; i < constants->count; i++) {
+                gc_mark_value(pGc, constants->values[i]);
+            }
+        }
+    }
+}
+
+// Shared by the threads loading modules. Everything in the module table is
+// only touched while holding `lock`.
+typedef struct {
+    ModuleTable* modules;
+    pthread_mutex_t lock;
+    // Signaled when a module is queued or a thread is done with one.
+    pthread_cond_t changed;
+    // Slots of the modules waiting to be read.
+    size_t* queue;
+    size_t queue_count;
+    size_t queue_capacity;
+    // Threads reading a module, which may queue more.
+    int busy;
+} Loader;
+
+static void enqueue(Loader* pLoader, size_t const slot) {
+    Module* module = &pLoader->modules->modules[slot];
+    if (module->state != MODULE_new) {
+        return;
+    }
+    module->state = MODULE_reading;
+    if (pLoader->queue_count == pLoader->queue_capacity) {
+        size_t const capacity =
+            pLoader->queue_capacity < CLOX_MODULE_MIN_CAPACITY
+                ? CLOX_MODULE_MIN_CAPACITY
+                : pLoader->queue_capacity * 2;
+        pLoader->queue = memory_reallocate(
+            MEMORY_source, pLoader->queue,
+            sizeof(*pLoader->queue) * pLoader->queue_capacity,
+            sizeof(*pLoader->queue) * capacity);
+        pLoader->queue_capacity = capacity;
+    }
+    pLoader->queue[pLoader->queue_count] = slot;
+    pLoader->queue_count += 1;
+    pthread_cond_broadcast(&pLoader->changed);
+}
+
+// Returns the NUL-terminated contents of the file at `path`, or NULL.
+static char* read_file(char const* path, size_t* pLength) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    size_t capacity = CLOX_SCANNER_CHUNK_SIZE;
+    size_t length = 0;
+    char* source = memory_reallocate(MEMORY_source, NULL, 0, capacity);
+    for (;;) {
+        length += fread(source + length, 1, capacity - 1 - length, file);
+        if (length < capacity - 1) {
+            break;
+        }
+        source = memory_reallocate(MEMORY_source, source, capacity,
+                                   capacity * 2);
+        capacity *= 2;
+    }
+    bool const failed = ferror(file) != 0;
+    fclose(file);
+    if (failed) {
+        memory_reallocate(MEMORY_source, source, capacity, 0);
+        return NULL;
+    }
+    source = memory_reallocate(MEMORY_source, source, capacity, length + 1);
+    source[length] = '\0';
+    *pLength = length;
+    return source;
+}
+
+// Reads and scans the module in `slot`, and queues the modules it imports.
+// Imports are found in the tokens, so only a full compile tells whether
+// they're well placed.
+static void load_module(Loader* pLoader, size_t const slot) {
+    // Names are allocated on their own and never move.
+    pthread_mutex_lock(&pLoader->lock);
+    char const* path = pLoader->modules->paths.names[slot].chars;
+    pthread_mutex_unlock(&pLoader->lock);
+
+    size_t length = 0;
+    char* source = read_file(path, &length);
+    Scanner scanner = {0};
+    Token const* tokens = NULL;
+    size_t token_count = 0;
+    if (source != NULL) {
+        scanner = scanner_new_scanned_alloc(source, length);
+        tokens = scanner_tokens(&scanner, &token_count);
+    }
+
+    pthread_mutex_lock(&pLoader->lock);
+    Module* module = &pLoader->modules->modules[slot];
+    module->state = source != NULL ? MODULE_scanned : MODULE_unreadable;
+    module->source = source;
+    module->length = length;
+    module->scanner = scanner;
+    for (size_t i = 0; i + 1 < token_count; i++) {
+        if (tokens[i].type == TOKEN_IMPORT &&
+            tokens[i + 1].type == TOKEN_STRING) {
+            // The quotes aren't part of the path.
+            size_t const imported =
+                module_table_resolve(pLoader->modules, tokens[i + 1].start + 1,
+                                     tokens[i + 1].length - 2);
+            enqueue(pLoader, imported);
+        }
+    }
+    pthread_mutex_unlock(&pLoader->lock);
+}
+
+static void* load_modules(void* argument) {
+    Loader* loader = argument;
+    pthread_mutex_lock(&loader->lock);
+    for (;;) {
+        // Threads wait as long as one that's busy may still queue modules.
+        while (loader->queue_count == 0 && loader->busy > 0) {
+            pthread_cond_wait(&loader->changed, &loader->lock);
+        }
+        if (loader->queue_count == 0) {
+            break;
+        }
+        loader->queue_count -= 1;
+        size_t const slot = loader->queue[loader->queue_count];
+        loader->busy += 1;
+        pthread_mutex_unlock(&loader->lock);
+        load_module(loader, slot);
+        pthread_mutex_lock(&loader->lock);
+        loader->busy -= 1;
+        pthread_cond_broadcast(&loader->changed);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+// Reads every new module and what it imports, on `thread_count` threads
+// including the calling one. Returns whether there were new modules.
+static bool read_modules(ModuleTable* pModules, int const thread_count) {
+    Loader loader = {.modules = pModules,
+                     .queue = NULL,
+                     .queue_count = 0,
+                     .queue_capacity = 0,
+                     .busy = 0};
+    pthread_mutex_init(&loader.lock, NULL);
+    pthread_cond_init(&loader.changed, NULL);
+    for (size_t slot = 0; slot < pModules->paths.count; slot++) {
+        enqueue(&loader, slot);
+    }
+    bool const queued = loader.queue_count > 0;
+
+    pthread_t threads[CLOX_MODULE_MAX_THREADS];
+    int started = 0;
+    while (queued && started + 1 < thread_count &&
+           pthread_create(&threads[started], NULL, load_modules, &loader) ==
+               0) {
+        started += 1;
+    }
+    load_modules(&loader);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&loader.changed);
+    pthread_mutex_destroy(&loader.lock);
+    memory_reallocate(MEMORY_source, loader.queue,
+                      sizeof(*loader.queue) * loader.queue_capacity, 0);
+    return queued;
+}
+
+// Compiles a scanned module. Its source is dropped either way, a module
+// that failed is read again by the next load.
+static bool compile_module(ModuleTable* pModules, size_t const slot,
+                           GarbageCollector* pGc, GlobalTable* pGlobals,
+                           Output* pOutput) {
+    // Names never move, unlike the table's array of them.
+    char const* path = pModules->paths.names[slot].chars;
+    int const length = pModules->paths.names[slot].length;
+    // The function is a root as soon as it's in the table.
+    ObjectFunction* function = object_function_new(pGc);
+    pModules->modules[slot].function = function;
+    function->name = object_string_copy(pGc, path, (size_t)length);
+    gc_write_barrier(pGc, &function->object, VALUE_OBJECT(function->name));
+
+    // Compiling may add modules, which moves the table.
+    bool const compiled =
+        compiler_compile(&pModules->modules[slot].scanner, &function->chunk,
+                         pGc, pGlobals, pModules, pOutput);
+    Module* module = &pModules->modules[slot];
+    drop_source(module);
+    if (!compiled) {
+        fprintf(stderr, "In module \"%s\".\n", path);
+        module->state = MODULE_new;
+        module->function = NULL;
+        return false;
+    }
+    chunk_freeze(&function->chunk);
+    // Its constants stop being roots, and those added after the function
+    // was scanned would be missed by the cycle under way.
+    gc_barrier_back(pGc, &function->object);
+    module->state = MODULE_compiled;
+    return true;
+}
+
+bool module_table_load(ModuleTable* pModules, GarbageCollector* pGc,
+                       GlobalTable* pGlobals, Output* pOutput,
+                       int thread_count) {
+    assert(pModules != NULL);
+    if (thread_count <= 0) {
+        long const processors = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = processors > 0 ? (int)processors : 1;
+    }
+    if (thread_count > CLOX_MODULE_MAX_THREADS) {
+        thread_count = CLOX_MODULE_MAX_THREADS;
+    }
+    bool loaded = true;
+    // Compiling finds the imports the scan found, unless it fails first.
+    // Modules it adds on top of those are read in another round.
+    while (loaded && read_modules(pModules, thread_count)) {
+        for (size_t slot = 0; slot < pModules->paths.count; slot++) {
+            Module* module = &pModules->modules[slot];
+            if (module->state == MODULE_unreadable) {
+                fprintf(stderr, "Could not read module \"%s\".\n",
+                        pModules->paths.names[slot].chars);
+                module->state = MODULE_new;
+                loaded = false;
+            } else if (module->state == MODULE_scanned &&
+                       !compile_module(pModules, slot, pGc, pGlobals,
+                                       pOutput)) {
+                loaded = false;
+            }
+        }
+    }
+    return loaded;
+}
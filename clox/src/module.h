@@ -0,0 +1,74 @@
+#ifndef CLOX_MODULE_H
+#define CLOX_MODULE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gc.h"      // GarbageCollector
+#include "global.h"  // GlobalTable
+#include "object.h"  // ObjectFunction
+#include "output.h"  // Output
+#include "scanner.h" // Scanner
+
+// Module operands are a 16-bit slot index.
+#define CLOX_MODULE_MAX (UINT16_MAX + 1)
+
+typedef enum {
+    // Imported by compiled code, but not loaded yet.
+    MODULE_new,
+    // Being read and scanned on a thread.
+    MODULE_reading,
+    // Scanned, waiting to be compiled.
+    MODULE_scanned,
+    MODULE_compiled,
+    // Couldn't be read, it's reported before it's compiled.
+    MODULE_unreadable
+} ModuleState;
+
+typedef struct {
+    ModuleState state;
+    // Only the first `import` of a module runs it.
+    bool ran;
+    // The source and its tokens, from reading until compiling.
+    char* source;
+    size_t length;
+    Scanner scanner;
+    // Compiled top-level code of the module, run like a function without
+    // parameters.
+    ObjectFunction* function;
+} Module;
+
+// Modules of a VM, one per path they're imported by. Paths are relative to
+// the working directory and are resolved to dense slots the way global
+// names are, so an `import` only indexes `modules`. Modules share the VM's
+// globals and stay compiled as long as the VM lives.
+typedef struct {
+    GlobalTable paths;
+    Module* modules;
+    size_t capacity;
+} ModuleTable;
+
+ModuleTable module_table_new_alloc(void) __attribute__((warn_unused_result));
+
+void module_table_free(ModuleTable* pModules);
+
+// Returns the slot of the module at `path`, adding a new one if needed.
+size_t module_table_resolve(ModuleTable* pModules, char const* path,
+                            int const length);
+
+// The compiled functions are roots.
+void module_table_mark(ModuleTable const* pModules, GarbageCollector* pGc);
+
+// Loads every new module, and the modules they import in turn. The import
+// graph is followed on `thread_count` threads, 0 for one per online
+// processor, which read and scan a module each at a time. The modules are
+// then compiled on the calling thread, since compiling allocates on the
+// VM's heap and resolves its globals. Returns false after reporting a
+// module that can't be read or compiled. Such modules are new again, so a
+// later load tries them once more.
+bool module_table_load(ModuleTable* pModules, GarbageCollector* pGc,
+                       GlobalTable* pGlobals, Output* pOutput,
+                       int thread_count);
+
+#endif // !CLOX_MODULE_H
@@ -0,0 +1,56 @@
+#ifndef CLOX_NUMBER_H
+#define CLOX_NUMBER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// At most this many significant digits fit in the 64-bit significand.
+#define CLOX_NUMBER_MAX_DIGITS 19
+
+// A decimal literal as significand * 10^exponent, accumulated digit by digit
+// while the scanner consumes the literal. Digits past the first
+// CLOX_NUMBER_MAX_DIGITS significant ones only move the exponent.
+typedef struct {
+    uint64_t significand;
+    int32_t exponent;
+    int digits;
+    // Set when a nonzero digit didn't fit in the significand.
+    bool truncated;
+} Decimal;
+
+static inline Decimal number_decimal_new(void) {
+    return (Decimal){
+        .significand = 0, .exponent = 0, .digits = 0, .truncated = false};
+}
+
+static inline void number_push_digit(Decimal* pDecimal, char const digit,
+                                     bool const is_fraction) {
+    if (pDecimal->digits == 0 && digit == '0') {
+        // Leading zeros are not significant.
+        pDecimal->exponent -= is_fraction;
+    } else if (pDecimal->digits < CLOX_NUMBER_MAX_DIGITS) {
+        pDecimal->significand = pDecimal->significand * 10 + (digit - '0');
+        pDecimal->digits += 1;
+        pDecimal->exponent -= is_fraction;
+    } else {
+        pDecimal->truncated |= digit != '0';
+        pDecimal->exponent += !is_fraction;
+    }
+}
+
+// Converts the accumulated literal to the double closest to it, rounding
+// exactly like strtod(). `lexeme` is the literal's text, it's only read when
+// neither fast path can prove its result is correctly rounded.
+double number_to_double(Decimal const* pDecimal, char const* lexeme,
+                        int const length);
+
+// Enough for the sign, 17 digits, the point, zeros up to the point and the
+// exponent of any double.
+#define CLOX_NUMBER_FORMAT_MAX 32
+
+// Writes the shortest decimal that reads back as `value` to `buffer`,
+// returning its length. Plain notation is used for magnitudes in
+// [1e-6, 1e21), exponent notation like "1.5e+21" otherwise.
+int number_format(double const value, char buffer[CLOX_NUMBER_FORMAT_MAX]);
+
+#endif // !CLOX_NUMBER_H
@@ -0,0 +1,287 @@
+#include "object.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "chunk.h"  // chunk_*
+#include "gc.h"     // GarbageCollector, gc_*
+#include "intern.h" // intern_*
+#include "output.h" // Output, output_*
+#include "shape.h"  // Shape
+#include "value.h"  // Value, VALUE_*
+
+#define CLOX_INSTANCE_MIN_FIELDS 4
+
+static Object* allocate_object(GarbageCollector* pGc, size_t const size,
+                               ObjectType const type) {
+    Object* object = gc_reallocate(pGc, NULL, 0, size);
+    assert(object != NULL);
+    object->type = type;
+    gc_link_object(pGc, object);
+    return object;
+}
+
+// The string is linked into the heap by link_string(), once it's known to be
+// new.
+static ObjectString* allocate_string(GarbageCollector* pGc,
+                                     size_t const length) {
+    ObjectString* string =
+        gc_reallocate(pGc, NULL, 0, sizeof(*string) + length + 1);
+    assert(string != NULL);
+    string->object.type = OBJECT_string;
+    string->length = length;
+    return string;
+}
+
+static ObjectString* link_string(GarbageCollector* pGc, ObjectString* string,
+                                 uint32_t const hash) {
+    string->hash = hash;
+    gc_link_object(pGc, &string->object);
+    intern_table_add(&pGc->strings, string);
+    return string;
+}
+
+ObjectString* object_string_copy(GarbageCollector* pGc, char const* chars,
+                                 size_t const length) {
+    uint32_t const hash = intern_hash(chars, length);
+    ObjectString* interned =
+        intern_table_find(&pGc->strings, chars, length, hash);
+    if (interned != NULL) {
+        gc_revive(pGc, &interned->object);
+        return interned;
+    }
+    ObjectString* string = allocate_string(pGc, length);
+    memcpy(string->chars, chars, length);
+    string->chars[length] = '\0';
+    return link_string(pGc, string, hash);
+}
+
+ObjectString* object_string_concatenate(GarbageCollector* pGc,
+                                        ObjectString const* a,
+                                        ObjectString const* b) {
+    // Both operands must stay reachable by the caller while the result is
+    // allocated, since the allocation may advance the collector.
+    size_t const length = a->length + b->length;
+    ObjectString* string = allocate_string(pGc, length);
+    memcpy(string->chars, a->chars, a->length);
+    memcpy(string->chars + a->length, b->chars, b->length);
+    string->chars[length] = '\0';
+    uint32_t const hash = intern_hash(string->chars, length);
+    ObjectString* interned =
+        intern_table_find(&pGc->strings, string->chars, length, hash);
+    if (interned != NULL) {
+        gc_reallocate(pGc, string, sizeof(*string) + length + 1, 0);
+        gc_revive(pGc, &interned->object);
+        return interned;
+    }
+    return link_string(pGc, string, hash);
+}
+
+ObjectFunction* object_function_new(GarbageCollector* pGc) {
+    ObjectFunction* function = (ObjectFunction*)allocate_object(
+        pGc, sizeof(*function), OBJECT_function);
+    function->arity = 0;
+    function->chunk = chunk_new_alloc();
+    function->name = NULL;
+    return function;
+}
+
+ObjectNative* object_native_new(GarbageCollector* pGc, NativeFn function) {
+    ObjectNative* native =
+        (ObjectNative*)allocate_object(pGc, sizeof(*native), OBJECT_native);
+    native->function = function;
+    return native;
+}
+
+ObjectFiber* object_fiber_new(GarbageCollector* pGc,
+                              ObjectFunction* function) {
+    // The arrays are allocated before the fiber: they can't be collected
+    // while the fiber is allocated, but a fiber nothing points to yet could
+    // be while they are.
+    size_t const stack_capacity =
+        function != NULL ? 1 + function->chunk.stack_size : 1;
+    Value* stack =
+        gc_reallocate(pGc, NULL, 0, sizeof(*stack) * stack_capacity);
+    CallFrame* frames =
+        gc_reallocate(pGc, NULL, 0, sizeof(*frames) * CLOX_FIBER_MIN_FRAMES);
+    assert(stack != NULL && frames != NULL);
+    ObjectFiber* fiber =
+        (ObjectFiber*)allocate_object(pGc, sizeof(*fiber), OBJECT_fiber);
+    fiber->state = FIBER_new;
+    fiber->stack = stack;
+    fiber->stack_top = stack;
+    fiber->stack_capacity = stack_capacity;
+    fiber->frames = frames;
+    fiber->frame_count = 0;
+    fiber->frame_capacity = CLOX_FIBER_MIN_FRAMES;
+    fiber->caller = NULL;
+    fiber->next_ready = NULL;
+    if (function != NULL) {
+        *fiber->stack_top = VALUE_OBJECT(function);
+        fiber->stack_top += 1;
+        fiber->frames[0] = (CallFrame){.function = function,
+                                       .chunk = &function->chunk,
+                                       .ip = function->chunk.code,
+                                       .slots = fiber->stack};
+        fiber->frame_count = 1;
+    }
+    return fiber;
+}
+
+void object_fiber_reserve_stack(GarbageCollector* pGc, ObjectFiber* fiber,
+                                size_t const count) {
+    size_t const needed = (size_t)(fiber->stack_top - fiber->stack) + count;
+    if (needed <= fiber->stack_capacity) {
+        return;
+    }
+    size_t capacity = fiber->stack_capacity * 2;
+    if (capacity < needed) {
+        capacity = needed;
+    }
+    Value* stack = gc_reallocate(pGc, fiber->stack,
+                                 sizeof(*stack) * fiber->stack_capacity,
+                                 sizeof(*stack) * capacity);
+    assert(stack != NULL);
+    fiber->stack_top = stack + (fiber->stack_top - fiber->stack);
+    for (int i = 0; i < fiber->frame_count; i++) {
+        CallFrame* frame = &fiber->frames[i];
+        frame->slots = stack + (frame->slots - fiber->stack);
+    }
+    fiber->stack = stack;
+    fiber->stack_capacity = capacity;
+}
+
+void object_fiber_reserve_frame(GarbageCollector* pGc, ObjectFiber* fiber) {
+    if (fiber->frame_count < fiber->frame_capacity) {
+        return;
+    }
+    int const capacity = fiber->frame_capacity * 2;
+    CallFrame* frames = gc_reallocate(
+        pGc, fiber->frames, sizeof(*frames) * (size_t)fiber->frame_capacity,
+        sizeof(*frames) * (size_t)capacity);
+    assert(frames != NULL);
+    fiber->frames = frames;
+    fiber->frame_capacity = capacity;
+}
+
+ObjectClass* object_class_new(GarbageCollector* pGc, ObjectString* name) {
+    ObjectClass* klass =
+        (ObjectClass*)allocate_object(pGc, sizeof(*klass), OBJECT_class);
+    klass->name = name;
+    return klass;
+}
+
+ObjectInstance* object_instance_new(GarbageCollector* pGc,
+                                    ObjectClass* klass, Shape* root) {
+    ObjectInstance* instance = (ObjectInstance*)allocate_object(
+        pGc, sizeof(*instance), OBJECT_instance);
+    instance->klass = klass;
+    instance->shape = root;
+    instance->fields = NULL;
+    instance->field_capacity = 0;
+    return instance;
+}
+
+void object_instance_reserve(GarbageCollector* pGc, ObjectInstance* instance,
+                             uint32_t const count) {
+    if (count <= instance->field_capacity) {
+        return;
+    }
+    uint32_t capacity = (instance->field_capacity < CLOX_INSTANCE_MIN_FIELDS
+                             ? CLOX_INSTANCE_MIN_FIELDS
+                             : instance->field_capacity * 2);
+    if (capacity < count) {
+        capacity = count;
+    }
+    Value* fields = gc_reallocate(
+        pGc, instance->fields, sizeof(*fields) * instance->field_capacity,
+        sizeof(*fields) * capacity);
+    assert(fields != NULL);
+    // Slots past the shape's field count are never read, but the collector
+    // may look at the array before the new field is stored.
+    for (uint32_t i = instance->field_capacity; i < capacity; i++) {
+        fields[i] = VALUE_NIL;
+    }
+    instance->fields = fields;
+    instance->field_capacity = capacity;
+}
+
+size_t object_size(Object const* object) {
+    assert(object != NULL);
+    switch (object->type) {
+    case OBJECT_string:
+        return sizeof(ObjectString) + ((ObjectString const*)object)->length +
+               1;
+    case OBJECT_function:
+        return sizeof(ObjectFunction);
+    case OBJECT_native:
+        return sizeof(ObjectNative);
+    case OBJECT_class:
+        return sizeof(ObjectClass);
+    case OBJECT_instance:
+        return sizeof(ObjectInstance);
+    case OBJECT_fiber:
+        return sizeof(ObjectFiber);
+    }
+    return 0; // Unreachable.
+}
+
+void object_free(GarbageCollector* pGc, Object* object) {
+    assert(object != NULL);
+    switch (object->type) {
+    case OBJECT_string:
+        intern_table_remove(&pGc->strings, (ObjectString const*)object);
+        break;
+    case OBJECT_function:
+        chunk_free(&((ObjectFunction*)object)->chunk);
+        break;
+    case OBJECT_native:
+    case OBJECT_class:
+        break;
+    case OBJECT_instance: {
+        ObjectInstance* instance = (ObjectInstance*)object;
+        gc_reallocate(pGc, instance->fields,
+                      sizeof(*instance->fields) * instance->field_capacity, 0);
+        break;
+    }
+    case OBJECT_fiber: {
+        ObjectFiber* fiber = (ObjectFiber*)object;
+        gc_reallocate(pGc, fiber->stack,
+                      sizeof(*fiber->stack) * fiber->stack_capacity, 0);
+        gc_reallocate(pGc, fiber->frames,
+                      sizeof(*fiber->frames) * (size_t)fiber->frame_capacity,
+                      0);
+        break;
+    }
+    }
+    gc_reallocate(pGc, object, object_size(object), 0);
+}
+
+void object_print(Output* pOutput, Object const* object) {
+    assert(object != NULL);
+    switch (object->type) {
+    case OBJECT_string:
+        output_write(pOutput, ((ObjectString const*)object)->chars,
+                     ((ObjectString const*)object)->length);
+        break;
+    case OBJECT_function:
+        output_printf(pOutput, "<fn %s>",
+                      ((ObjectFunction const*)object)->name->chars);
+        break;
+    case OBJECT_native:
+        output_write_string(pOutput, "<native fn>");
+        break;
+    case OBJECT_class:
+        object_print(pOutput, &((ObjectClass const*)object)->name->object);
+        break;
+    case OBJECT_instance:
+        object_print(pOutput,
+                     &((ObjectInstance const*)object)->klass->name->object);
+        output_write_string(pOutput, " instance");
+        break;
+    case OBJECT_fiber:
+        output_write_string(pOutput, "<fiber>");
+        break;
+    }
+}
@@ -0,0 +1,181 @@
+#ifndef CLOX_OBJECT_H
+#define CLOX_OBJECT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h"  // Chunk
+#include "output.h" // Output
+#include "value.h"  // Value, Object
+
+struct GarbageCollector;
+struct Shape;
+struct VirtualMachine;
+
+// Frames a fiber has room for before its frame array grows.
+#define CLOX_FIBER_MIN_FRAMES 4
+
+typedef enum {
+    OBJECT_string,
+    OBJECT_function,
+    OBJECT_native,
+    OBJECT_class,
+    OBJECT_instance,
+    OBJECT_fiber
+} ObjectType;
+
+// Header shared by every heap allocated value. `color` is owned by the
+// garbage collector (see gc.h) and `next` links all objects of a heap.
+struct Object {
+    ObjectType type;
+    uint8_t color;
+    struct Object* next;
+};
+
+// Strings are interned, equal strings are the same object.
+typedef struct ObjectString {
+    Object object;
+    size_t length;
+    uint32_t hash;
+    char chars[];
+} ObjectString;
+
+typedef struct {
+    Object object;
+    int arity;
+    Chunk chunk;
+    ObjectString* name;
+} ObjectFunction;
+
+// Called with the callee and its arguments on the stack, and replaces them
+// with its result. Returns false after reporting a runtime error.
+typedef bool (*NativeFn)(struct VirtualMachine* pVm, int argument_count,
+                         Value* arguments);
+
+typedef struct {
+    Object object;
+    NativeFn function;
+} ObjectNative;
+
+typedef struct {
+    Object object;
+    ObjectString* name;
+} ObjectClass;
+
+// Fields live in a flat array, their slots are given by the shape.
+typedef struct {
+    Object object;
+    ObjectClass* klass;
+    struct Shape* shape;
+    Value* fields;
+    uint32_t field_capacity;
+} ObjectInstance;
+
+typedef struct {
+    // NULL for the script's frame, which runs the VM's chunk.
+    ObjectFunction* function;
+    Chunk* chunk;
+    // Only up to date while the frame isn't the running one, run() keeps
+    // the running frame's in a local.
+    uint8_t* ip;
+    // Slot 0 holds the callee, then come the arguments and locals.
+    Value* slots;
+} CallFrame;
+
+typedef enum {
+    FIBER_new,
+    FIBER_suspended,
+    FIBER_running,
+    FIBER_done
+} FiberState;
+
+// A coroutine with its own value stack and call frames. Both start out just
+// large enough for the fiber's function and grow as calls need it, so an
+// idle fiber costs a few hundred bytes.
+typedef struct ObjectFiber {
+    Object object;
+    FiberState state;
+    Value* stack;
+    Value* stack_top;
+    size_t stack_capacity;
+    CallFrame* frames;
+    int frame_count;
+    int frame_capacity;
+    // Fiber that resumed this one and gets what it yields or returns, NULL
+    // for fibers run by the scheduler.
+    struct ObjectFiber* caller;
+    // Next fiber in the scheduler's run queue.
+    struct ObjectFiber* next_ready;
+} ObjectFiber;
+
+#define OBJECT_TYPE(value) (VALUE_AS_OBJECT(value)->type)
+
+#define OBJECT_IS_STRING(value) object_is_type(value, OBJECT_string)
+
+#define OBJECT_IS_FUNCTION(value) object_is_type(value, OBJECT_function)
+#define OBJECT_IS_NATIVE(value) object_is_type(value, OBJECT_native)
+#define OBJECT_IS_CLASS(value) object_is_type(value, OBJECT_class)
+#define OBJECT_IS_INSTANCE(value) object_is_type(value, OBJECT_instance)
+#define OBJECT_IS_FIBER(value) object_is_type(value, OBJECT_fiber)
+
+#define OBJECT_AS_STRING(value) ((ObjectString*)VALUE_AS_OBJECT(value))
+#define OBJECT_AS_FUNCTION(value) ((ObjectFunction*)VALUE_AS_OBJECT(value))
+#define OBJECT_AS_NATIVE(value) ((ObjectNative*)VALUE_AS_OBJECT(value))
+#define OBJECT_AS_CLASS(value) ((ObjectClass*)VALUE_AS_OBJECT(value))
+#define OBJECT_AS_INSTANCE(value) ((ObjectInstance*)VALUE_AS_OBJECT(value))
+#define OBJECT_AS_FIBER(value) ((ObjectFiber*)VALUE_AS_OBJECT(value))
+
+static inline bool object_is_type(Value const value, ObjectType const type) {
+    return VALUE_IS_OBJECT(value) && VALUE_AS_OBJECT(value)->type == type;
+}
+
+ObjectString* object_string_copy(struct GarbageCollector* pGc,
+                                 char const* chars, size_t const length);
+
+ObjectString* object_string_concatenate(struct GarbageCollector* pGc,
+                                        ObjectString const* a,
+                                        ObjectString const* b);
+
+// Creates a function with an empty chunk and no name yet.
+ObjectFunction* object_function_new(struct GarbageCollector* pGc);
+
+ObjectNative* object_native_new(struct GarbageCollector* pGc,
+                                NativeFn function);
+
+// Creates a fiber that will call `function` without arguments, or an empty
+// one to run the script on if `function` is NULL. The function must stay
+// reachable by the caller while the fiber is allocated.
+ObjectFiber* object_fiber_new(struct GarbageCollector* pGc,
+                              ObjectFunction* function);
+
+// Makes room for `count` more values on the fiber's stack, moving it if it
+// has to grow. Pointers into the stack have to be reloaded afterwards.
+void object_fiber_reserve_stack(struct GarbageCollector* pGc,
+                                ObjectFiber* fiber, size_t const count);
+
+// Makes room for one more frame, moving the frames if they have to grow.
+void object_fiber_reserve_frame(struct GarbageCollector* pGc,
+                                ObjectFiber* fiber);
+
+// `name` must stay reachable by the caller while the class is allocated.
+ObjectClass* object_class_new(struct GarbageCollector* pGc,
+                              ObjectString* name);
+
+// Creates an instance without fields, of shape `root`. `klass` must stay
+// reachable by the caller while the instance is allocated.
+ObjectInstance* object_instance_new(struct GarbageCollector* pGc,
+                                    ObjectClass* klass, struct Shape* root);
+
+// Makes room for `count` fields. The instance must stay reachable by the
+// caller, since the allocation may advance the collector.
+void object_instance_reserve(struct GarbageCollector* pGc,
+                             ObjectInstance* instance, uint32_t const count);
+
+size_t object_size(Object const* object);
+
+void object_free(struct GarbageCollector* pGc, Object* object);
+
+void object_print(Output* pOutput, Object const* object);
+
+#endif // !CLOX_OBJECT_H
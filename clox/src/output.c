@@ -0,0 +1,95 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "output.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "memory.h" // memory_*
+#include "number.h" // number_format
+
+Output output_new_alloc(int const fd) {
+    char* buffer =
+        memory_reallocate(MEMORY_vm, NULL, 0, CLOX_OUTPUT_BUFFER_SIZE);
+    return (Output){.buffer = buffer, .length = 0, .fd = fd};
+}
+
+void output_free(Output* pOutput) {
+    assert(pOutput != NULL);
+    output_flush(pOutput);
+    pOutput->buffer = memory_reallocate(MEMORY_vm, pOutput->buffer,
+                                        CLOX_OUTPUT_BUFFER_SIZE, 0);
+}
+
+static void write_all(int const fd, char const* chars, size_t const length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t const count = write(fd, chars + written, length - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            // Nobody is reading anymore, what's left is dropped like stdio
+            // would.
+            return;
+        }
+        written += (size_t)count;
+    }
+}
+
+void output_flush(Output* pOutput) {
+    assert(pOutput != NULL);
+    write_all(pOutput->fd, pOutput->buffer, pOutput->length);
+    pOutput->length = 0;
+}
+
+void output_write(Output* pOutput, char const* chars, size_t const length) {
+    assert(pOutput != NULL);
+    if (pOutput->length + length > CLOX_OUTPUT_BUFFER_SIZE) {
+        output_flush(pOutput);
+        if (length > CLOX_OUTPUT_BUFFER_SIZE) {
+            // Too large to be worth copying.
+            write_all(pOutput->fd, chars, length);
+            return;
+        }
+    }
+    memcpy(pOutput->buffer + pOutput->length, chars, length);
+    pOutput->length += length;
+}
+
+void output_write_string(Output* pOutput, char const* string) {
+    output_write(pOutput, string, strlen(string));
+}
+
+void output_write_char(Output* pOutput, char const c) {
+    assert(pOutput != NULL);
+    if (pOutput->length == CLOX_OUTPUT_BUFFER_SIZE) {
+        output_flush(pOutput);
+    }
+    pOutput->buffer[pOutput->length] = c;
+    pOutput->length += 1;
+}
+
+void output_write_number(Output* pOutput, double const number) {
+    char digits[CLOX_NUMBER_FORMAT_MAX];
+    int const length = number_format(number, digits);
+    output_write(pOutput, digits, (size_t)length);
+}
+
+void output_printf(Output* pOutput, char const* format, ...) {
+    assert(pOutput != NULL);
+    char chars[256];
+    va_list args;
+    va_start(args, format);
+    int const length = vsnprintf(chars, sizeof(chars), format, args);
+    va_end(args);
+    assert(length >= 0);
+    output_write(pOutput, chars,
+                 (size_t)length < sizeof(chars) ? (size_t)length
+                                                : sizeof(chars) - 1);
+}
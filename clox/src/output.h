@@ -0,0 +1,35 @@
+#ifndef CLOX_OUTPUT_H
+#define CLOX_OUTPUT_H
+
+#include <stddef.h>
+
+#define CLOX_OUTPUT_BUFFER_SIZE (64 * 1024)
+
+// Buffers what a VM prints and hands it to the file descriptor in large
+// writes. It bypasses stdio, so it has to be flushed before anything else
+// writes to the same descriptor.
+typedef struct {
+    char* buffer;
+    size_t length;
+    int fd;
+} Output;
+
+Output output_new_alloc(int const fd) __attribute__((warn_unused_result));
+
+void output_free(Output* pOutput);
+
+void output_flush(Output* pOutput);
+
+void output_write(Output* pOutput, char const* chars, size_t const length);
+
+void output_write_string(Output* pOutput, char const* string);
+
+void output_write_char(Output* pOutput, char const c);
+
+void output_write_number(Output* pOutput, double const number);
+
+// Only meant for debug output, it goes through vsnprintf().
+__attribute__((format(printf, 2, 3))) void
+output_printf(Output* pOutput, char const* format, ...);
+
+#endif // !CLOX_OUTPUT_H
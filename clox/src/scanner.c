@@ -1,15 +1,113 @@
+// For pthreads and sysconf().
+#define _POSIX_C_SOURCE 200112L
+
 #include "scanner.h"
 
+#include <assert.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
-#include "token.h" // Token, TokenType
+#include "memory.h" // memory_*
+#include "number.h" // Decimal, number_*
+#include "token.h"  // Token, TokenType
 
 Scanner scanner_new(char const* const source) {
-    return (Scanner){.start = source, .current = source, .line = 1};
+    return (Scanner){.start = source,
+                     .current = source,
+                     .line = 1,
+                     .input = NULL,
+                     .exhausted = true,
+                     .end = NULL,
+                     .buffers = {{NULL, 0}, {NULL, 0}},
+                     .active = 0,
+                     .moved = false,
+                     .pieces = NULL,
+                     .piece_count = 0,
+                     .piece = 0,
+                     .next_token = 0,
+                     .line_delta = 0,
+                     .rescanning = false};
+}
+
+Scanner scanner_new_stream_alloc(FILE* input) {
+    assert(input != NULL);
+    Scanner scanner = scanner_new("");
+    scanner.input = input;
+    scanner.exhausted = false;
+    scanner.end = scanner.current;
+    return scanner;
+}
+
+static void free_pieces(Scanner* pScanner);
+
+void scanner_free(Scanner* pScanner) {
+    assert(pScanner != NULL);
+    free_pieces(pScanner);
+    for (int i = 0; i < 2; i++) {
+        ScannerBuffer const* buffer = &pScanner->buffers[i];
+        memory_reallocate(MEMORY_source, buffer->chars, buffer->capacity, 0);
+        pScanner->buffers[i] = (ScannerBuffer){NULL, 0};
+    }
 }
 
-static bool is_at_end(Scanner const* pScanner) {
+// Appends the next chunk of the input behind the partially scanned token.
+static bool refill(Scanner* pScanner) {
+    if (pScanner->exhausted) {
+        return false;
+    }
+    size_t const kept = (size_t)(pScanner->end - pScanner->start);
+    size_t const offset = (size_t)(pScanner->current - pScanner->start);
+    // The first refill of a token moves it to the retired buffer. Later ones
+    // compact and grow the active buffer, which then holds nothing else.
+    bool const in_place = pScanner->moved;
+    if (!in_place) {
+        pScanner->active ^= 1;
+        pScanner->moved = true;
+    }
+    ScannerBuffer* buffer = &pScanner->buffers[pScanner->active];
+    char const* kept_start = pScanner->start;
+    if (buffer->capacity < kept + CLOX_SCANNER_CHUNK_SIZE + 1) {
+        size_t capacity = buffer->capacity * 2;
+        if (capacity < kept + CLOX_SCANNER_CHUNK_SIZE + 1) {
+            capacity = kept + CLOX_SCANNER_CHUNK_SIZE + 1;
+        }
+        size_t const kept_offset =
+            in_place ? (size_t)(kept_start - buffer->chars) : 0;
+        buffer->chars = memory_reallocate(MEMORY_source, buffer->chars,
+                                          buffer->capacity, capacity);
+        buffer->capacity = capacity;
+        if (in_place) {
+            kept_start = buffer->chars + kept_offset;
+        }
+    }
+    memmove(buffer->chars, kept_start, kept);
+
+    size_t const count = fread(buffer->chars + kept, sizeof(char),
+                               CLOX_SCANNER_CHUNK_SIZE, pScanner->input);
+    if (count < CLOX_SCANNER_CHUNK_SIZE) {
+        pScanner->exhausted = true;
+    }
+    buffer->chars[kept + count] = '\0';
+    pScanner->start = buffer->chars;
+    pScanner->current = buffer->chars + offset;
+    pScanner->end = buffer->chars + kept + count;
+    return count > 0;
+}
+
+// Makes sure `count` characters from `current` on are buffered, unless the
+// input ends first.
+static void fill(Scanner* pScanner, ptrdiff_t const count) {
+    while (pScanner->input != NULL &&
+           pScanner->end - pScanner->current < count && refill(pScanner)) {
+    }
+}
+
+static bool is_at_end(Scanner* pScanner) {
+    fill(pScanner, 1);
     return *pScanner->current == '\0';
 }
 
@@ -26,9 +124,13 @@ static bool match(Scanner* pScanner, char expected) {
     return true;
 }
 
-static char peek(Scanner* pScanner) { return *pScanner->current; }
+static char peek(Scanner* pScanner) {
+    fill(pScanner, 1);
+    return *pScanner->current;
+}
 
 static char peek_next(Scanner* pScanner) {
+    fill(pScanner, 2);
     if (is_at_end(pScanner)) {
         return '\0';
     }
@@ -37,6 +139,8 @@ static char peek_next(Scanner* pScanner) {
 
 static void skipWhitespace(Scanner* pScanner) {
     for (;;) {
+        // Nothing skipped has to be kept across a refill.
+        pScanner->start = pScanner->current;
         char c = peek(pScanner);
         switch (c) {
         case ' ':
@@ -53,6 +157,7 @@ static void skipWhitespace(Scanner* pScanner) {
                 // A comment goes until the end of the line.
                 while (peek(pScanner) != '\n' && !is_at_end(pScanner)) {
                     advance(pScanner);
+                    pScanner->start = pScanner->current;
                 }
             } else {
                 return;
@@ -68,14 +173,16 @@ static Token make_token(Scanner const* pScanner, TokenType type) {
     return (Token){.type = type,
                    .start = pScanner->start,
                    .length = (int)(pScanner->current - pScanner->start),
-                   .line = pScanner->line};
+                   .line = pScanner->line,
+                   .number = 0};
 }
 
 static Token error_token(Scanner const* pScanner, char const* message) {
     return (Token){.type = TOKEN_ERROR,
                    .start = message,
                    .length = (int)strlen(message),
-                   .line = pScanner->line};
+                   .line = pScanner->line,
+                   .number = 0};
 }
 
 static Token string(Scanner* pScanner) {
@@ -96,18 +203,24 @@ static Token string(Scanner* pScanner) {
 static bool is_digit(char c) { return c >= '0' && c <= '9'; }
 
 static Token number(Scanner* pScanner) {
+    // The value is accumulated while the digits are consumed, so that the
+    // literal is read only once.
+    Decimal decimal = number_decimal_new();
+    number_push_digit(&decimal, pScanner->current[-1], false);
     while (is_digit(peek(pScanner))) {
-        advance(pScanner);
+        number_push_digit(&decimal, advance(pScanner), false);
     }
     // Look for a fractional part.
     if (peek(pScanner) == '.' && is_digit(peek_next(pScanner))) {
         // Consume the "."
         advance(pScanner);
         while (is_digit(peek(pScanner))) {
-            advance(pScanner);
+            number_push_digit(&decimal, advance(pScanner), true);
         }
     }
-    return make_token(pScanner, TOKEN_NUMBER);
+    Token token = make_token(pScanner, TOKEN_NUMBER);
+    token.number = number_to_double(&decimal, token.start, token.length);
+    return token;
 }
 
 static bool is_alpha(char c) {
@@ -144,7 +257,15 @@ static TokenType identifier_type(Scanner const* pScanner) {
         }
         break;
     case 'i':
-        return check_keyword(pScanner, 1, 1, "f", TOKEN_IF);
+        if (pScanner->current - pScanner->start > 1) {
+            switch (pScanner->start[1]) {
+            case 'f':
+                return check_keyword(pScanner, 2, 0, "", TOKEN_IF);
+            case 'm':
+                return check_keyword(pScanner, 2, 4, "port", TOKEN_IMPORT);
+            }
+        }
+        break;
     case 'n':
         return check_keyword(pScanner, 1, 2, "il", TOKEN_NIL);
     case 'o':
@@ -180,7 +301,8 @@ static Token identifier(Scanner* pScanner) {
     return make_token(pScanner, identifier_type(pScanner));
 }
 
-Token scanner_scan_token(Scanner* pScanner) {
+static Token scan_token(Scanner* pScanner) {
+    pScanner->moved = false;
     skipWhitespace(pScanner);
     pScanner->start = pScanner->current;
     if (is_at_end(pScanner)) {
@@ -235,3 +357,248 @@ Token scanner_scan_token(Scanner* pScanner) {
 
     return error_token(pScanner, "Unexpected character.");
 }
+
+// Where a token starts and the line it starts on.
+typedef struct {
+    char const* at;
+    int line;
+} ScanMark;
+
+typedef struct ScanPiece {
+    char const* begin;
+    char const* end;
+    Token* tokens;
+    size_t token_count;
+    size_t token_capacity;
+    // Lines are counted from 1 at `begin`. If the guess was right, the
+    // tokens of the previous piece end where the first token starts.
+    ScanMark first;
+    // First token starting at or past `end`, where the next piece takes
+    // over, or the end of the source.
+    ScanMark stop;
+    pthread_t thread;
+    bool threaded;
+} ScanPiece;
+
+static ScanMark token_mark(Scanner const* pScanner) {
+    int line = pScanner->line;
+    // Only strings span lines, the scanner is on their last one.
+    if (*pScanner->start == '"') {
+        for (char const* c = pScanner->start; c < pScanner->current; c++) {
+            if (*c == '\n') {
+                line -= 1;
+            }
+        }
+    }
+    return (ScanMark){.at = pScanner->start, .line = line};
+}
+
+static void push_token(ScanPiece* pPiece, Token const token) {
+    if (pPiece->token_count == pPiece->token_capacity) {
+        size_t const capacity =
+            pPiece->token_capacity < 256 ? 256 : pPiece->token_capacity * 2;
+        pPiece->tokens = memory_reallocate(
+            MEMORY_source, pPiece->tokens,
+            pPiece->token_capacity * sizeof(Token), capacity * sizeof(Token));
+        pPiece->token_capacity = capacity;
+    }
+    pPiece->tokens[pPiece->token_count++] = token;
+}
+
+static void* scan_piece(void* argument) {
+    ScanPiece* piece = argument;
+    Scanner scanner = scanner_new(piece->begin);
+    for (;;) {
+        Token const token = scan_token(&scanner);
+        ScanMark const mark = token_mark(&scanner);
+        if (piece->first.at == NULL) {
+            piece->first = mark;
+        }
+        // The end of the source is past the end of every piece.
+        if (mark.at >= piece->end) {
+            piece->stop = mark;
+            return NULL;
+        }
+        push_token(piece, token);
+    }
+}
+
+static void join_piece(ScanPiece* pPiece) {
+    if (pPiece->threaded) {
+        pthread_join(pPiece->thread, NULL);
+        pPiece->threaded = false;
+    }
+}
+
+static void free_piece_tokens(ScanPiece* pPiece) {
+    memory_reallocate(MEMORY_source, pPiece->tokens,
+                      pPiece->token_capacity * sizeof(Token), 0);
+    pPiece->tokens = NULL;
+    pPiece->token_count = 0;
+    pPiece->token_capacity = 0;
+}
+
+static void free_pieces(Scanner* pScanner) {
+    if (pScanner->pieces == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < pScanner->piece_count; i++) {
+        join_piece(&pScanner->pieces[i]);
+        free_piece_tokens(&pScanner->pieces[i]);
+    }
+    memory_reallocate(MEMORY_source, pScanner->pieces,
+                      pScanner->piece_count * sizeof(ScanPiece), 0);
+    pScanner->pieces = NULL;
+    pScanner->piece_count = 0;
+}
+
+// Moves on to the piece the token at `mark` starts in. Pieces it starts past
+// were inside a string, their tokens are dropped unseen. Whether the guess of
+// the new piece held shows in where its first token starts.
+static void enter_piece(Scanner* pScanner, ScanMark const mark) {
+    ScanPiece* piece = &pScanner->pieces[pScanner->piece];
+    while (pScanner->piece + 1 < pScanner->piece_count &&
+           mark.at >= piece->end) {
+        free_piece_tokens(piece);
+        pScanner->piece += 1;
+        piece = &pScanner->pieces[pScanner->piece];
+        join_piece(piece);
+    }
+    pScanner->next_token = 0;
+    pScanner->line_delta = mark.line - piece->first.line;
+    pScanner->rescanning = mark.at != piece->first.at;
+}
+
+static ScanPiece new_piece(char const* begin, char const* end) {
+    return (ScanPiece){.begin = begin,
+                       .end = end,
+                       .tokens = NULL,
+                       .token_count = 0,
+                       .token_capacity = 0,
+                       .first = {NULL, 0},
+                       .stop = {NULL, 0},
+                       .threaded = false};
+}
+
+Scanner scanner_new_parallel_alloc(char const* const source,
+                                   size_t const length, int thread_count) {
+    assert(source != NULL && source[length] == '\0');
+    if (thread_count <= 0) {
+        long const processors = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = processors > 0 ? (int)processors : 1;
+    }
+    Scanner scanner = scanner_new(source);
+    if (thread_count < 2 || length == 0) {
+        return scanner;
+    }
+
+    size_t const capacity = (size_t)thread_count;
+    ScanPiece* pieces =
+        memory_reallocate(MEMORY_source, NULL, 0, capacity * sizeof(ScanPiece));
+    char const* const end = source + length;
+    char const* begin = source;
+    size_t count = 0;
+    while (begin < end) {
+        // A piece ends after the first newline past its share of the source,
+        // the last one at the end.
+        char const* split = end;
+        if (count + 1 < capacity) {
+            char const* target = source + length / capacity * (count + 1);
+            if (target < begin) {
+                target = begin;
+            }
+            char const* newline = memchr(target, '\n', (size_t)(end - target));
+            if (newline != NULL) {
+                split = newline + 1;
+            }
+        }
+        pieces[count++] = new_piece(begin, split);
+        begin = split;
+    }
+    scanner.pieces =
+        memory_reallocate(MEMORY_source, pieces, capacity * sizeof(ScanPiece),
+                          count * sizeof(ScanPiece));
+    scanner.piece_count = count;
+    for (size_t i = 0; i < count; i++) {
+        ScanPiece* piece = &scanner.pieces[i];
+        // Without a thread of its own, the piece is scanned right away.
+        piece->threaded =
+            pthread_create(&piece->thread, NULL, scan_piece, piece) == 0;
+        if (!piece->threaded) {
+            scan_piece(piece);
+        }
+    }
+    // The first piece starts outside of any string, so its guess holds.
+    join_piece(&scanner.pieces[0]);
+    enter_piece(&scanner, scanner.pieces[0].first);
+    return scanner;
+}
+
+Scanner scanner_new_scanned_alloc(char const* const source,
+                                  size_t const length) {
+    assert(source != NULL && source[length] == '\0');
+    Scanner scanner = scanner_new(source);
+    scanner.pieces = memory_reallocate(MEMORY_source, NULL, 0,
+                                       sizeof(ScanPiece));
+    scanner.pieces[0] = new_piece(source, source + length);
+    scanner.piece_count = 1;
+    scan_piece(&scanner.pieces[0]);
+    enter_piece(&scanner, scanner.pieces[0].first);
+    return scanner;
+}
+
+Token const* scanner_tokens(Scanner const* pScanner, size_t* pCount) {
+    assert(pScanner != NULL && pScanner->piece_count == 1);
+    *pCount = pScanner->pieces[0].token_count;
+    return pScanner->pieces[0].tokens;
+}
+
+// Hands out the tokens of the current piece, then moves on to the piece of
+// the token after them. In a piece whose guess didn't hold, the scanner
+// scans until a token starts in a piece whose guess does.
+static Token next_piece_token(Scanner* pScanner) {
+    for (;;) {
+        ScanPiece const* piece = &pScanner->pieces[pScanner->piece];
+        bool const is_last = pScanner->piece + 1 == pScanner->piece_count;
+        if (pScanner->rescanning) {
+            Token const token = scan_token(pScanner);
+            ScanMark const mark = token_mark(pScanner);
+            if (mark.at < piece->end || is_last) {
+                return token;
+            }
+            enter_piece(pScanner, mark);
+            if (!pScanner->rescanning) {
+                // The token is the first one of the new piece.
+                pScanner->next_token = 1;
+            }
+            return token;
+        }
+
+        if (pScanner->next_token < piece->token_count) {
+            Token token = piece->tokens[pScanner->next_token++];
+            token.line += pScanner->line_delta;
+            return token;
+        }
+        ScanMark const stop = {.at = piece->stop.at,
+                               .line = piece->stop.line + pScanner->line_delta};
+        if (is_last) {
+            return (Token){.type = TOKEN_EOF,
+                           .start = stop.at,
+                           .length = 0,
+                           .line = stop.line,
+                           .number = 0};
+        }
+        enter_piece(pScanner, stop);
+        if (pScanner->rescanning) {
+            pScanner->current = stop.at;
+            pScanner->line = stop.line;
+        }
+    }
+}
+
+Token scanner_scan_token(Scanner* pScanner) {
+    if (pScanner->pieces != NULL) {
+        return next_piece_token(pScanner);
+    }
+    return scan_token(pScanner);
+}
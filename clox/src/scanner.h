@@ -1,16 +1,83 @@
 #ifndef CLOX_SCANNER_H
 #define CLOX_SCANNER_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
 #include "token.h" // Token
 
+// Bytes read from a stream per refill.
+#define CLOX_SCANNER_CHUNK_SIZE 4096
+
+// Sources from this size on are worth scanning on several threads.
+#define CLOX_SCANNER_PARALLEL_MIN_SIZE (1 << 20)
+
+// Piece of a source scanned on its own thread, defined in scanner.c.
+struct ScanPiece;
+
+typedef struct {
+    char* chars;
+    size_t capacity;
+} ScannerBuffer;
+
+// Scans either a string held in memory or a stream, which is read in chunks
+// so that memory stays bounded by the longest token rather than the input.
+// A token's lexeme stays valid until the second next scanner_scan_token(),
+// long enough for the parser's `previous` and `current` tokens.
 typedef struct {
     char const* start;
     char const* current;
     int line;
+    // NULL when scanning a string.
+    FILE* input;
+    bool exhausted;
+    // End of the buffered input, always followed by a '\0'.
+    char const* end;
+    // The token being scanned is moved to the other buffer on its first
+    // refill, which keeps the previous token intact in the retired one.
+    ScannerBuffer buffers[2];
+    int active;
+    bool moved;
+    // Pieces of a source scanned ahead by scanner_new_parallel_alloc(), NULL
+    // otherwise. Their tokens are handed out in order, `line_delta` turns
+    // the lines of the current piece's tokens into lines of the source.
+    struct ScanPiece* pieces;
+    size_t piece_count;
+    size_t piece;
+    size_t next_token;
+    int line_delta;
+    // The current piece was scanned on a wrong guess, so the scanner scans
+    // it again itself.
+    bool rescanning;
 } Scanner;
 
 Scanner scanner_new(char const* const source);
 
+Scanner scanner_new_stream_alloc(FILE* input)
+    __attribute__((warn_unused_result));
+
+// Scans the `length` characters of `source`, which must stay alive and
+// NUL-terminated, split at newlines into a piece per thread. Every thread
+// guesses that its piece doesn't start inside a string. A wrong guess only
+// costs rescanning that piece when its tokens are reached. 0 threads means
+// one per online processor.
+Scanner scanner_new_parallel_alloc(char const* source, size_t length,
+                                   int thread_count)
+    __attribute__((warn_unused_result));
+
+// Scans all of the `length` characters of `source` right away, on the
+// calling thread, so that a source can be scanned on another thread than
+// the one compiling it.
+Scanner scanner_new_scanned_alloc(char const* source, size_t length)
+    __attribute__((warn_unused_result));
+
+// Tokens scanned by scanner_new_scanned_alloc(), without the EOF. They're
+// only valid until the scanner is freed.
+Token const* scanner_tokens(Scanner const* pScanner, size_t* pCount);
+
+void scanner_free(Scanner* pScanner);
+
 Token scanner_scan_token(Scanner* pScanner);
 
 #endif // !CLOX_SCANNER_H
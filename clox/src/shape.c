@@ -0,0 +1,102 @@
+#include "shape.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gc.h"     // GarbageCollector, gc_*
+#include "memory.h" // memory_*
+#include "object.h" // ObjectString
+
+#define CLOX_SHAPE_MIN_TRANSITIONS 4
+
+static Shape* allocate_shape(Shape* parent, ObjectString* key,
+                             uint32_t const field_count) {
+    Shape* shape = memory_reallocate(MEMORY_heap, NULL, 0, sizeof(*shape));
+    *shape = (Shape){.parent = parent,
+                     .key = key,
+                     .field_count = field_count,
+                     .transitions = NULL,
+                     .transition_count = 0,
+                     .transition_capacity = 0};
+    return shape;
+}
+
+static void free_shape(Shape* shape) {
+    for (uint32_t i = 0; i < shape->transition_count; i++) {
+        free_shape(shape->transitions[i]);
+    }
+    memory_reallocate(MEMORY_heap, shape->transitions,
+                      sizeof(*shape->transitions) * shape->transition_capacity,
+                      0);
+    memory_reallocate(MEMORY_heap, shape, sizeof(*shape), 0);
+}
+
+static void mark_shape(Shape const* shape, GarbageCollector* pGc) {
+    gc_mark_object(pGc, (Object*)shape->key);
+    for (uint32_t i = 0; i < shape->transition_count; i++) {
+        mark_shape(shape->transitions[i], pGc);
+    }
+}
+
+ShapeTree shape_tree_new_alloc(void) {
+    return (ShapeTree){.root = allocate_shape(NULL, NULL, 0)};
+}
+
+void shape_tree_free(ShapeTree* pShapes) {
+    assert(pShapes != NULL);
+    free_shape(pShapes->root);
+    pShapes->root = NULL;
+}
+
+void shape_tree_mark(ShapeTree const* pShapes, GarbageCollector* pGc) {
+    assert(pShapes != NULL);
+    mark_shape(pShapes->root, pGc);
+}
+
+int64_t shape_find(Shape const* shape, ObjectString const* key) {
+    assert(shape != NULL);
+    // Names are interned, so comparing pointers is enough.
+    for (; shape->key != NULL; shape = shape->parent) {
+        if (shape->key == key) {
+            return shape->field_count - 1;
+        }
+    }
+    return -1;
+}
+
+Shape* shape_transition(Shape* shape, ObjectString* key) {
+    assert(shape != NULL);
+    for (uint32_t i = 0; i < shape->transition_count; i++) {
+        if (shape->transitions[i]->key == key) {
+            return shape->transitions[i];
+        }
+    }
+
+    if (shape->transition_count >= shape->transition_capacity) {
+        uint32_t const capacity =
+            (shape->transition_capacity < CLOX_SHAPE_MIN_TRANSITIONS
+                 ? CLOX_SHAPE_MIN_TRANSITIONS
+                 : shape->transition_capacity * 2);
+        shape->transitions = memory_reallocate(
+            MEMORY_heap, shape->transitions,
+            sizeof(*shape->transitions) * shape->transition_capacity,
+            sizeof(*shape->transitions) * capacity);
+        shape->transition_capacity = capacity;
+    }
+    Shape* child = allocate_shape(shape, key, shape->field_count + 1);
+    shape->transitions[shape->transition_count] = child;
+    shape->transition_count += 1;
+    return child;
+}
+
+void shape_cache_add(ShapeCache* pCache, Shape const* shape, Shape* target,
+                     uint32_t const slot) {
+    assert(pCache != NULL);
+    if (pCache->count == CLOX_SHAPE_CACHE_WAYS) {
+        return;
+    }
+    pCache->entries[pCache->count] =
+        (ShapeCacheEntry){.shape = shape, .target = target, .slot = slot};
+    pCache->count += 1;
+}
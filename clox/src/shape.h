@@ -0,0 +1,79 @@
+#ifndef CLOX_SHAPE_H
+#define CLOX_SHAPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct GarbageCollector;
+// object.h can't be included, it includes chunk.h and so this header.
+struct ObjectString;
+
+// Shapes a property access site remembers before it goes megamorphic.
+#define CLOX_SHAPE_CACHE_WAYS 4
+
+// Hidden class of an instance: the names of its fields and the slot each is
+// stored in. Instances that got the same fields in the same order share
+// their shape, so a field's slot is found by comparing a single pointer.
+// Shapes form a tree: each one is its parent plus the field `key`, which
+// lives in the last slot.
+typedef struct Shape {
+    struct Shape* parent;
+    // Interned, NULL for the empty root shape.
+    struct ObjectString* key;
+    uint32_t field_count;
+    struct Shape** transitions;
+    uint32_t transition_count;
+    uint32_t transition_capacity;
+} Shape;
+
+// Every shape of a VM, which all live as long as the VM does so that the
+// inline caches of cached chunks never point to freed ones.
+typedef struct {
+    Shape* root;
+} ShapeTree;
+
+typedef struct {
+    Shape const* shape;
+    // Shape the instance has after a store, the same as `shape` unless the
+    // store adds the field.
+    Shape* target;
+    uint32_t slot;
+} ShapeCacheEntry;
+
+// Inline cache of one get or set property instruction, keyed by the shape
+// of the receiver. One entry is a monomorphic site, more a polymorphic one.
+typedef struct {
+    ShapeCacheEntry entries[CLOX_SHAPE_CACHE_WAYS];
+    uint32_t count;
+} ShapeCache;
+
+ShapeTree shape_tree_new_alloc(void) __attribute__((warn_unused_result));
+
+void shape_tree_free(ShapeTree* pShapes);
+
+// Field names are referenced from the shapes, so they're roots.
+void shape_tree_mark(ShapeTree const* pShapes, struct GarbageCollector* pGc);
+
+// Returns the slot of field `key` in `shape`, or -1 if it has no such
+// field.
+int64_t shape_find(Shape const* shape, struct ObjectString const* key);
+
+// Returns the shape of an instance of `shape` that gets field `key` added.
+Shape* shape_transition(Shape* shape, struct ObjectString* key);
+
+static inline ShapeCacheEntry const* shape_cache_find(ShapeCache const* cache,
+                                                      Shape const* shape) {
+    for (uint32_t i = 0; i < cache->count; i++) {
+        if (cache->entries[i].shape == shape) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Remembers an access, unless the cache is full. Megamorphic sites keep
+// their first shapes and take the slow path for all others.
+void shape_cache_add(ShapeCache* pCache, Shape const* shape, Shape* target,
+                     uint32_t const slot);
+
+#endif // !CLOX_SHAPE_H
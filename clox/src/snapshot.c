@@ -0,0 +1,793 @@
+// For mmap().
+#define _DEFAULT_SOURCE
+
+#include "snapshot.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chunk.h"  // Chunk, chunk_*
+#include "gc.h"     // GarbageCollector, GcMarkRootsFn, gc_*
+#include "global.h" // GlobalTable, global_table_*
+#include "line.h"   // LineInfo
+#include "memory.h" // memory_*
+#include "module.h" // Module, ModuleTable, module_table_*
+#include "object.h" // Object*, OBJECT_*, object_*
+#include "shape.h"  // Shape, shape_*
+#include "value.h"  // Value, VALUE_*
+#include "vm.h"     // VirtualMachine, vm_*
+
+#define CLOX_SNAPSHOT_VERSION 3
+// Snapshots are written in the byte order of the machine, which the loader
+// checks with this.
+#define CLOX_SNAPSHOT_BYTE_ORDER 0x01020304u
+#define CLOX_SNAPSHOT_MIN_CAPACITY 256
+
+// Reference to no object, like the name of the script's function.
+#define NO_OBJECT UINT32_MAX
+
+static char const magic[8] = {'C', 'L', 'O', 'X', 'S', 'N', 'A', 'P'};
+
+// A header and three sections. Objects are numbered in the order they come
+// in. The first section has what it takes to allocate each object, the
+// second the references each one holds, so that they can point to objects
+// further on, and the third the globals and modules.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t object_count;
+    uint64_t objects_size;
+    uint64_t links_size;
+    uint64_t globals_size;
+    // FNV-1a hash of the sections. The loader checks the structure of what
+    // it reads but not the code, which is trusted like the binary is, so
+    // this is what turns away damaged files.
+    uint64_t checksum;
+} SnapshotHeader;
+
+typedef struct {
+    uint8_t* bytes;
+    size_t count;
+    size_t capacity;
+} Buffer;
+
+typedef struct {
+    VirtualMachine* vm;
+    // Objects by number, which is also the queue of objects to write.
+    Object** objects;
+    size_t count;
+    size_t capacity;
+    // Open addressing table from object to number + 1, 0 marks an empty
+    // bucket.
+    uint32_t* buckets;
+    size_t bucket_capacity;
+    Buffer sections[3];
+    bool failed;
+} Saver;
+
+enum { SECTION_objects, SECTION_links, SECTION_globals };
+
+static void buffer_write(Buffer* pBuffer, void const* data, size_t const size) {
+    if (pBuffer->capacity - pBuffer->count < size) {
+        size_t capacity = pBuffer->capacity < CLOX_SNAPSHOT_MIN_CAPACITY
+                              ? CLOX_SNAPSHOT_MIN_CAPACITY
+                              : pBuffer->capacity * 2;
+        while (capacity - pBuffer->count < size) {
+            capacity *= 2;
+        }
+        pBuffer->bytes = memory_reallocate(MEMORY_vm, pBuffer->bytes,
+                                           pBuffer->capacity, capacity);
+        pBuffer->capacity = capacity;
+    }
+    if (size > 0) {
+        memcpy(pBuffer->bytes + pBuffer->count, data, size);
+    }
+    pBuffer->count += size;
+}
+
+static uint64_t checksum(uint8_t const* bytes, size_t const size,
+                         uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3u;
+    }
+    return hash;
+}
+
+static void write_u8(Buffer* pBuffer, uint8_t const value) {
+    buffer_write(pBuffer, &value, sizeof(value));
+}
+
+static void write_u32(Buffer* pBuffer, uint32_t const value) {
+    buffer_write(pBuffer, &value, sizeof(value));
+}
+
+static void write_u64(Buffer* pBuffer, uint64_t const value) {
+    buffer_write(pBuffer, &value, sizeof(value));
+}
+
+static size_t hash_object(Object const* object) {
+    uintptr_t const address = (uintptr_t)object;
+    return (size_t)((address >> 4) * 0x9E3779B97F4A7C15u);
+}
+
+static uint32_t* find_bucket(Saver const* pSaver, Object const* object) {
+    size_t const mask = pSaver->bucket_capacity - 1;
+    for (size_t index = hash_object(object) & mask;;
+         index = (index + 1) & mask) {
+        uint32_t* bucket = &pSaver->buckets[index];
+        if (*bucket == 0 || pSaver->objects[*bucket - 1] == object) {
+            return bucket;
+        }
+    }
+}
+
+static void grow_numbers(Saver* pSaver) {
+    size_t const capacity = pSaver->capacity < CLOX_SNAPSHOT_MIN_CAPACITY
+                                ? CLOX_SNAPSHOT_MIN_CAPACITY
+                                : pSaver->capacity * 2;
+    pSaver->objects = memory_reallocate(
+        MEMORY_vm, pSaver->objects, sizeof(*pSaver->objects) * pSaver->capacity,
+        sizeof(*pSaver->objects) * capacity);
+    pSaver->capacity = capacity;
+    // Twice as many buckets as objects keeps the load factor at most 1/2.
+    memory_reallocate(MEMORY_vm, pSaver->buckets,
+                      sizeof(*pSaver->buckets) * pSaver->bucket_capacity, 0);
+    pSaver->bucket_capacity = capacity * 2;
+    pSaver->buckets = memory_reallocate(
+        MEMORY_vm, NULL, 0, sizeof(*pSaver->buckets) * pSaver->bucket_capacity);
+    memset(pSaver->buckets, 0,
+           sizeof(*pSaver->buckets) * pSaver->bucket_capacity);
+    for (size_t i = 0; i < pSaver->count; i++) {
+        *find_bucket(pSaver, pSaver->objects[i]) = (uint32_t)i + 1;
+    }
+}
+
+// Numbers objects the first time they're referenced, which queues them to
+// be written.
+static void write_reference(Saver* pSaver, Buffer* pBuffer, Object* object) {
+    if (object == NULL) {
+        write_u32(pBuffer, NO_OBJECT);
+        return;
+    }
+    if (pSaver->count == pSaver->capacity) {
+        grow_numbers(pSaver);
+    }
+    uint32_t* bucket = find_bucket(pSaver, object);
+    if (*bucket == 0) {
+        if (pSaver->count == NO_OBJECT) {
+            pSaver->failed = true;
+            return;
+        }
+        pSaver->objects[pSaver->count] = object;
+        pSaver->count += 1;
+        *bucket = (uint32_t)pSaver->count;
+    }
+    write_u32(pBuffer, *bucket - 1);
+}
+
+static void write_value(Saver* pSaver, Buffer* pBuffer, Value const value) {
+    write_u8(pBuffer, (uint8_t)value.type);
+    switch (value.type) {
+    case VALUE_nil:
+    case VALUE_undefined:
+        break;
+    case VALUE_bool:
+        write_u8(pBuffer, VALUE_AS_BOOL(value));
+        break;
+    case VALUE_number: {
+        double const number = VALUE_AS_NUMBER(value);
+        buffer_write(pBuffer, &number, sizeof(number));
+        break;
+    }
+    case VALUE_object:
+        write_reference(pSaver, pBuffer, VALUE_AS_OBJECT(value));
+        break;
+    }
+}
+
+static void save_function(Saver* pSaver, ObjectFunction* function) {
+    Buffer* objects = &pSaver->sections[SECTION_objects];
+    Chunk const* chunk = &function->chunk;
+    write_u32(objects, (uint32_t)function->arity);
+    write_u64(objects, chunk->count);
+    buffer_write(objects, chunk->code, chunk->count);
+    write_u64(objects, chunk->constants.count);
+    write_u64(objects, chunk->shape_cache_count);
+    write_u64(objects, chunk->line_vector.count);
+    for (size_t i = 0; i < chunk->line_vector.count; i++) {
+        write_u32(objects, (uint32_t)chunk->line_vector.lines[i].line);
+        write_u64(objects, chunk->line_vector.lines[i].offset);
+    }
+
+    Buffer* links = &pSaver->sections[SECTION_links];
+    write_reference(pSaver, links, (Object*)function->name);
+    for (size_t i = 0; i < chunk->constants.count; i++) {
+        write_value(pSaver, links, chunk->constants.values[i]);
+    }
+}
+
+// Fields are written in slot order with their names, which rebuild the
+// shape on loading.
+static void save_instance(Saver* pSaver, ObjectInstance* instance) {
+    Buffer* links = &pSaver->sections[SECTION_links];
+    uint32_t const field_count = instance->shape->field_count;
+    write_reference(pSaver, links, &instance->klass->object);
+    write_u32(links, field_count);
+    ObjectString** keys =
+        memory_reallocate(MEMORY_vm, NULL, 0, sizeof(*keys) * field_count + 1);
+    for (Shape const* shape = instance->shape; shape->key != NULL;
+         shape = shape->parent) {
+        keys[shape->field_count - 1] = shape->key;
+    }
+    for (uint32_t slot = 0; slot < field_count; slot++) {
+        write_reference(pSaver, links, &keys[slot]->object);
+        write_value(pSaver, links, instance->fields[slot]);
+    }
+    memory_reallocate(MEMORY_vm, keys, sizeof(*keys) * field_count + 1, 0);
+}
+
+// The run queue and the fibers waiting on a resume() belong to a running
+// program, so a fiber's links to other fibers aren't kept.
+static void save_fiber(Saver* pSaver, ObjectFiber* fiber) {
+    if (fiber == pSaver->vm->main_fiber) {
+        fprintf(stderr, "Can't snapshot the main fiber.\n");
+        pSaver->failed = true;
+        return;
+    }
+    Buffer* links = &pSaver->sections[SECTION_links];
+    size_t const depth = (size_t)(fiber->stack_top - fiber->stack);
+    write_u8(links, (uint8_t)fiber->state);
+    write_u64(links, depth);
+    write_u32(links, (uint32_t)fiber->frame_count);
+    for (size_t i = 0; i < depth; i++) {
+        write_value(pSaver, links, fiber->stack[i]);
+    }
+    for (int i = 0; i < fiber->frame_count; i++) {
+        CallFrame const* frame = &fiber->frames[i];
+        assert(frame->function != NULL);
+        write_reference(pSaver, links, &frame->function->object);
+        write_u64(links, (uint64_t)(frame->ip - frame->chunk->code));
+        write_u64(links, (uint64_t)(frame->slots - fiber->stack));
+    }
+}
+
+static void save_object(Saver* pSaver, Object* object) {
+    Buffer* objects = &pSaver->sections[SECTION_objects];
+    write_u8(objects, (uint8_t)object->type);
+    switch (object->type) {
+    case OBJECT_string: {
+        ObjectString const* string = (ObjectString const*)object;
+        write_u64(objects, string->length);
+        buffer_write(objects, string->chars, string->length);
+        break;
+    }
+    case OBJECT_function:
+        save_function(pSaver, (ObjectFunction*)object);
+        break;
+    case OBJECT_native: {
+        NativeFn const function = ((ObjectNative const*)object)->function;
+        uint32_t index = 0;
+        while (vm_native(index) != NULL && vm_native(index) != function) {
+            index += 1;
+        }
+        if (vm_native(index) == NULL) {
+            fprintf(stderr, "Can't snapshot an unknown native.\n");
+            pSaver->failed = true;
+        }
+        write_u32(objects, index);
+        break;
+    }
+    case OBJECT_class:
+        write_reference(pSaver, &pSaver->sections[SECTION_links],
+                        &((ObjectClass*)object)->name->object);
+        break;
+    case OBJECT_instance:
+        save_instance(pSaver, (ObjectInstance*)object);
+        break;
+    case OBJECT_fiber:
+        save_fiber(pSaver, (ObjectFiber*)object);
+        break;
+    }
+}
+
+static bool write_file(Saver const* pSaver, char const* path) {
+    SnapshotHeader header = {
+        .version = CLOX_SNAPSHOT_VERSION,
+        .byte_order = CLOX_SNAPSHOT_BYTE_ORDER,
+        .object_count = pSaver->count,
+        .objects_size = pSaver->sections[SECTION_objects].count,
+        .links_size = pSaver->sections[SECTION_links].count,
+        .globals_size = pSaver->sections[SECTION_globals].count,
+        .checksum = 0xcbf29ce484222325u};
+    memcpy(header.magic, magic, sizeof(magic));
+    for (int i = 0; i < 3; i++) {
+        header.checksum =
+            checksum(pSaver->sections[i].bytes, pSaver->sections[i].count,
+                     header.checksum);
+    }
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open file \"%s\"\n", path);
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int i = 0; i < 3; i++) {
+        Buffer const* section = &pSaver->sections[i];
+        written = written && (section->count == 0 ||
+                              fwrite(section->bytes, section->count, 1, file) ==
+                                  1);
+    }
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        fprintf(stderr, "Could not write file \"%s\"\n", path);
+    }
+    return written;
+}
+
+bool snapshot_save(VirtualMachine* pVm, char const* path) {
+    assert(pVm != NULL && path != NULL);
+    if (pVm->suspended) {
+        fprintf(stderr, "Can't snapshot a VM with a suspended program.\n");
+        return false;
+    }
+    Saver saver = {.vm = pVm};
+    Buffer* globals = &saver.sections[SECTION_globals];
+    write_u64(globals, pVm->globals.count);
+    for (size_t slot = 0; slot < pVm->globals.count; slot++) {
+        GlobalName const* name = &pVm->globals.names[slot];
+        write_u32(globals, (uint32_t)name->length);
+        buffer_write(globals, name->chars, (size_t)name->length);
+        write_value(&saver, globals, pVm->globals.values[slot]);
+    }
+    // Code refers to modules by slot too. Those that didn't compile are
+    // loaded again when they're next imported.
+    write_u64(globals, pVm->modules.paths.count);
+    for (size_t slot = 0; slot < pVm->modules.paths.count; slot++) {
+        GlobalName const* name = &pVm->modules.paths.names[slot];
+        Module const* module = &pVm->modules.modules[slot];
+        write_u32(globals, (uint32_t)name->length);
+        buffer_write(globals, name->chars, (size_t)name->length);
+        write_u8(globals, module->ran);
+        write_reference(&saver, globals, (Object*)module->function);
+    }
+    // Writing an object numbers the ones it references, so this runs until
+    // everything reachable is written.
+    for (size_t i = 0; i < saver.count && !saver.failed; i++) {
+        save_object(&saver, saver.objects[i]);
+    }
+
+    bool const saved = !saver.failed && write_file(&saver, path);
+    for (int i = 0; i < 3; i++) {
+        memory_reallocate(MEMORY_vm, saver.sections[i].bytes,
+                          saver.sections[i].capacity, 0);
+    }
+    memory_reallocate(MEMORY_vm, saver.objects,
+                      sizeof(*saver.objects) * saver.capacity, 0);
+    memory_reallocate(MEMORY_vm, saver.buckets,
+                      sizeof(*saver.buckets) * saver.bucket_capacity, 0);
+    return saved;
+}
+
+// Reads a section of the mapped file. Reading past its end fails the reader,
+// and every read after that gives zeros.
+typedef struct {
+    uint8_t const* at;
+    uint8_t const* end;
+    bool failed;
+} Reader;
+
+typedef struct {
+    VirtualMachine* vm;
+    // Objects by number, loaded so far. They're roots while loading.
+    Object** objects;
+    size_t count;
+    size_t capacity;
+    // Roots of the VM, marked along with the objects.
+    GcMarkRootsFn mark_roots;
+    void* roots_context;
+} Loader;
+
+static uint8_t const* read_span(Reader* pReader, size_t const size) {
+    if (pReader->failed || (size_t)(pReader->end - pReader->at) < size) {
+        pReader->failed = true;
+        return NULL;
+    }
+    uint8_t const* span = pReader->at;
+    pReader->at += size;
+    return span;
+}
+
+static void read_bytes(Reader* pReader, void* data, size_t const size) {
+    uint8_t const* span = read_span(pReader, size);
+    if (span != NULL) {
+        memcpy(data, span, size);
+    } else {
+        memset(data, 0, size);
+    }
+}
+
+static uint8_t read_u8(Reader* pReader) {
+    uint8_t value;
+    read_bytes(pReader, &value, sizeof(value));
+    return value;
+}
+
+static uint32_t read_u32(Reader* pReader) {
+    uint32_t value;
+    read_bytes(pReader, &value, sizeof(value));
+    return value;
+}
+
+static uint64_t read_u64(Reader* pReader) {
+    uint64_t value;
+    read_bytes(pReader, &value, sizeof(value));
+    return value;
+}
+
+// Returns the object a reference is to, which must have type `type`, or
+// NULL for no object if `nullable`.
+static Object* read_reference(Reader* pReader, Loader const* pLoader,
+                              ObjectType const type, bool const nullable) {
+    uint32_t const number = read_u32(pReader);
+    if (number == NO_OBJECT && nullable) {
+        return NULL;
+    }
+    if (number >= pLoader->count ||
+        pLoader->objects[number]->type != type) {
+        pReader->failed = true;
+        return NULL;
+    }
+    return pLoader->objects[number];
+}
+
+static Value read_value(Reader* pReader, Loader const* pLoader) {
+    switch (read_u8(pReader)) {
+    case VALUE_nil:
+        return VALUE_NIL;
+    case VALUE_undefined:
+        return VALUE_UNDEFINED;
+    case VALUE_bool:
+        return VALUE_BOOL(read_u8(pReader) != 0);
+    case VALUE_number: {
+        double number;
+        read_bytes(pReader, &number, sizeof(number));
+        return VALUE_NUMBER(number);
+    }
+    case VALUE_object: {
+        uint32_t const number = read_u32(pReader);
+        if (number < pLoader->count) {
+            return VALUE_OBJECT(pLoader->objects[number]);
+        }
+        break;
+    }
+    }
+    pReader->failed = true;
+    return VALUE_NIL;
+}
+
+static void mark_loaded(GarbageCollector* pGc, void* context) {
+    Loader const* loader = context;
+    for (size_t i = 0; i < loader->count; i++) {
+        gc_mark_object(pGc, loader->objects[i]);
+    }
+    loader->mark_roots(pGc, loader->roots_context);
+}
+
+// Objects are allocated empty, with their references to other objects
+// filled in by link_*(). They're added to the loader before anything else
+// is allocated for them, so that they're roots by then.
+static Object* add_object(Loader* pLoader, Object* object) {
+    pLoader->objects[pLoader->count] = object;
+    pLoader->count += 1;
+    return object;
+}
+
+static void load_function(Reader* pReader, Loader* pLoader) {
+    GarbageCollector* gc = &pLoader->vm->gc;
+    ObjectFunction* function =
+        (ObjectFunction*)add_object(pLoader, (Object*)object_function_new(gc));
+    function->arity = (int)read_u32(pReader);
+    size_t const count = read_u64(pReader);
+    uint8_t const* code = read_span(pReader, count);
+    size_t const constant_count = read_u64(pReader);
+    size_t const shape_cache_count = read_u64(pReader);
+    size_t const line_count = read_u64(pReader);
+    // Code has a line from its first byte on, and every line takes more
+    // than a byte of what's left.
+    if (code == NULL || constant_count > UINT8_MAX + 1 ||
+        shape_cache_count > CLOX_CHUNK_SHAPE_CACHES_MAX ||
+        (count > 0 && line_count == 0) ||
+        line_count > (size_t)(pReader->end - pReader->at)) {
+        pReader->failed = true;
+        return;
+    }
+    LineInfo* lines =
+        memory_reallocate(MEMORY_vm, NULL, 0, sizeof(*lines) * line_count + 1);
+    // Lines are searched by offset, which goes up from the first byte.
+    for (size_t i = 0; i < line_count; i++) {
+        lines[i].line = (int)read_u32(pReader);
+        lines[i].offset = read_u64(pReader);
+        if (lines[i].offset >= count ||
+            (i == 0 ? lines[i].offset != 0
+                    : lines[i].offset <= lines[i - 1].offset)) {
+            pReader->failed = true;
+        }
+    }
+    chunk_free(&function->chunk);
+    function->chunk = chunk_new_frozen_alloc(
+        code, count, constant_count, shape_cache_count, lines, line_count);
+    memory_reallocate(MEMORY_vm, lines, sizeof(*lines) * line_count + 1, 0);
+}
+
+static void load_object(Reader* pReader, Loader* pLoader) {
+    GarbageCollector* gc = &pLoader->vm->gc;
+    switch (read_u8(pReader)) {
+    case OBJECT_string: {
+        size_t const length = read_u64(pReader);
+        char const* chars = (char const*)read_span(pReader, length);
+        if (chars != NULL) {
+            add_object(pLoader,
+                       (Object*)object_string_copy(gc, chars, length));
+        }
+        return;
+    }
+    case OBJECT_function:
+        load_function(pReader, pLoader);
+        return;
+    case OBJECT_native: {
+        NativeFn const function = vm_native(read_u32(pReader));
+        if (function != NULL) {
+            add_object(pLoader, (Object*)object_native_new(gc, function));
+        }
+        return;
+    }
+    case OBJECT_class:
+        add_object(pLoader, (Object*)object_class_new(gc, NULL));
+        return;
+    case OBJECT_instance:
+        add_object(pLoader, (Object*)object_instance_new(
+                                gc, NULL, pLoader->vm->shapes.root));
+        return;
+    case OBJECT_fiber:
+        add_object(pLoader, (Object*)object_fiber_new(gc, NULL));
+        return;
+    }
+    pReader->failed = true;
+}
+
+static void link_function(Reader* pReader, Loader const* pLoader,
+                          ObjectFunction* function) {
+    function->name = (ObjectString*)read_reference(pReader, pLoader,
+                                                   OBJECT_string, true);
+    ValueVector* constants = &function->chunk.constants;
+    for (size_t i = 0; i < constants->count; i++) {
+        constants->values[i] = read_value(pReader, pLoader);
+    }
+}
+
+static void link_instance(Reader* pReader, Loader const* pLoader,
+                          ObjectInstance* instance) {
+    GarbageCollector* gc = &pLoader->vm->gc;
+    instance->klass =
+        (ObjectClass*)read_reference(pReader, pLoader, OBJECT_class, false);
+    uint32_t const field_count = read_u32(pReader);
+    // Every field takes more than a byte of what's left.
+    if (field_count > (size_t)(pReader->end - pReader->at)) {
+        pReader->failed = true;
+        return;
+    }
+    object_instance_reserve(gc, instance, field_count);
+    Shape* shape = instance->shape;
+    for (uint32_t slot = 0; slot < field_count && !pReader->failed; slot++) {
+        ObjectString* key = (ObjectString*)read_reference(pReader, pLoader,
+                                                          OBJECT_string, false);
+        if (key == NULL || shape_find(shape, key) >= 0) {
+            pReader->failed = true;
+            return;
+        }
+        instance->fields[slot] = read_value(pReader, pLoader);
+        shape = shape_transition(shape, key);
+    }
+    instance->shape = shape;
+}
+
+static void link_fiber(Reader* pReader, Loader const* pLoader,
+                       ObjectFiber* fiber) {
+    GarbageCollector* gc = &pLoader->vm->gc;
+    uint8_t const state = read_u8(pReader);
+    size_t const depth = read_u64(pReader);
+    uint32_t const frame_count = read_u32(pReader);
+    // Every value takes more than a byte of what's left, and every frame has
+    // its callee on the stack.
+    if (state > FIBER_done || depth > (size_t)(pReader->end - pReader->at) ||
+        frame_count > depth || frame_count > CLOX_FRAMES_MAX) {
+        pReader->failed = true;
+        return;
+    }
+    fiber->state = (FiberState)state;
+    object_fiber_reserve_stack(gc, fiber, depth);
+    for (size_t i = 0; i < depth; i++) {
+        fiber->stack[i] = read_value(pReader, pLoader);
+    }
+    fiber->stack_top = fiber->stack + depth;
+    for (uint32_t i = 0; i < frame_count && !pReader->failed; i++) {
+        ObjectFunction* function = (ObjectFunction*)read_reference(
+            pReader, pLoader, OBJECT_function, false);
+        size_t const ip = read_u64(pReader);
+        size_t const slots = read_u64(pReader);
+        if (function == NULL || ip > function->chunk.count || slots >= depth) {
+            pReader->failed = true;
+            return;
+        }
+        object_fiber_reserve_frame(gc, fiber);
+        fiber->frames[i] = (CallFrame){.function = function,
+                                       .chunk = &function->chunk,
+                                       .ip = function->chunk.code + ip,
+                                       .slots = fiber->stack + slots};
+        fiber->frame_count += 1;
+    }
+    // Room for what the running frame pushes, which its call reserved.
+    if (!pReader->failed && fiber->frame_count > 0) {
+        CallFrame const* frame = &fiber->frames[fiber->frame_count - 1];
+        object_fiber_reserve_stack(gc, fiber, frame->chunk->stack_size);
+    }
+}
+
+static void link_object(Reader* pReader, Loader const* pLoader,
+                        Object* object) {
+    switch (object->type) {
+    case OBJECT_string:
+    case OBJECT_native:
+        break;
+    case OBJECT_function:
+        link_function(pReader, pLoader, (ObjectFunction*)object);
+        break;
+    case OBJECT_class:
+        ((ObjectClass*)object)->name = (ObjectString*)read_reference(
+            pReader, pLoader, OBJECT_string, false);
+        break;
+    case OBJECT_instance:
+        link_instance(pReader, pLoader, (ObjectInstance*)object);
+        break;
+    case OBJECT_fiber:
+        link_fiber(pReader, pLoader, (ObjectFiber*)object);
+        break;
+    }
+    // The object may have been scanned while it was still empty.
+    gc_barrier_back(&pLoader->vm->gc, object);
+}
+
+// Globals get the same slots as in the VM that was saved, which the natives
+// and so a fresh VM agree with.
+static void load_globals(Reader* pReader, Loader const* pLoader) {
+    GlobalTable* globals = &pLoader->vm->globals;
+    uint64_t const count = read_u64(pReader);
+    for (uint64_t i = 0; i < count && !pReader->failed; i++) {
+        uint32_t const length = read_u32(pReader);
+        char const* name = (char const*)read_span(pReader, length);
+        if (name == NULL || length > INT32_MAX ||
+            global_table_resolve(globals, name, (int)length) != i) {
+            pReader->failed = true;
+            return;
+        }
+        globals->values[i] = read_value(pReader, pLoader);
+    }
+}
+
+static void load_modules(Reader* pReader, Loader const* pLoader) {
+    ModuleTable* modules = &pLoader->vm->modules;
+    uint64_t const count = read_u64(pReader);
+    for (uint64_t i = 0; i < count && !pReader->failed; i++) {
+        uint32_t const length = read_u32(pReader);
+        char const* path = (char const*)read_span(pReader, length);
+        if (path == NULL || length > INT32_MAX ||
+            module_table_resolve(modules, path, (int)length) != i) {
+            pReader->failed = true;
+            return;
+        }
+        Module* module = &modules->modules[i];
+        module->ran = read_u8(pReader) != 0;
+        module->function = (ObjectFunction*)read_reference(
+            pReader, pLoader, OBJECT_function, true);
+        module->state =
+            module->function != NULL ? MODULE_compiled : MODULE_new;
+    }
+}
+
+static bool load(VirtualMachine* pVm, uint8_t const* bytes, size_t size) {
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, bytes, sizeof(header));
+    size -= sizeof(header);
+    // Every object takes a byte at least.
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+        header.version != CLOX_SNAPSHOT_VERSION ||
+        header.byte_order != CLOX_SNAPSHOT_BYTE_ORDER ||
+        header.objects_size > size ||
+        header.links_size > size - header.objects_size ||
+        header.globals_size != size - header.objects_size - header.links_size ||
+        header.object_count > header.objects_size ||
+        checksum(bytes + sizeof(header), size, 0xcbf29ce484222325u) !=
+            header.checksum) {
+        return false;
+    }
+    Reader readers[3];
+    uint8_t const* at = bytes + sizeof(header);
+    uint64_t const sizes[3] = {header.objects_size, header.links_size,
+                               header.globals_size};
+    for (int i = 0; i < 3; i++) {
+        readers[i] = (Reader){.at = at, .end = at + sizes[i], .failed = false};
+        at += sizes[i];
+    }
+
+    GarbageCollector* gc = &pVm->gc;
+    Loader loader = {.vm = pVm,
+                     .capacity = header.object_count,
+                     .mark_roots = gc->mark_roots,
+                     .roots_context = gc->roots_context};
+    loader.objects = memory_reallocate(
+        MEMORY_vm, NULL, 0, sizeof(*loader.objects) * loader.capacity + 1);
+    gc->mark_roots = mark_loaded;
+    gc->roots_context = &loader;
+
+    Reader* objects = &readers[SECTION_objects];
+    for (size_t i = 0; i < loader.capacity && !objects->failed; i++) {
+        load_object(objects, &loader);
+        objects->failed = objects->failed || loader.count != i + 1;
+    }
+    Reader* links = &readers[SECTION_links];
+    for (size_t i = 0; i < loader.count && !objects->failed && !links->failed;
+         i++) {
+        link_object(links, &loader, loader.objects[i]);
+    }
+    load_globals(&readers[SECTION_globals], &loader);
+    load_modules(&readers[SECTION_globals], &loader);
+
+    bool loaded = true;
+    for (int i = 0; i < 3; i++) {
+        loaded = loaded && !readers[i].failed && readers[i].at == readers[i].end;
+    }
+    gc->mark_roots = loader.mark_roots;
+    gc->roots_context = loader.roots_context;
+    memory_reallocate(MEMORY_vm, loader.objects,
+                      sizeof(*loader.objects) * loader.capacity + 1, 0);
+    return loaded;
+}
+
+bool snapshot_load(VirtualMachine* pVm, char const* path) {
+    assert(pVm != NULL && path != NULL);
+    int const file = open(path, O_RDONLY);
+    if (file < 0) {
+        fprintf(stderr, "Could not open file \"%s\"\n", path);
+        return false;
+    }
+    struct stat status;
+    void* bytes = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        bytes = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE,
+                     file, 0);
+    }
+    close(file);
+    if (bytes == MAP_FAILED) {
+        fprintf(stderr, "Could not read file \"%s\"\n", path);
+        return false;
+    }
+    bool const loaded = load(pVm, bytes, (size_t)status.st_size);
+    munmap(bytes, (size_t)status.st_size);
+    if (!loaded) {
+        fprintf(stderr, "Not a snapshot of this clox: \"%s\"\n", path);
+    }
+    return loaded;
+}
@@ -0,0 +1,21 @@
+#ifndef CLOX_SNAPSHOT_H
+#define CLOX_SNAPSHOT_H
+
+#include <stdbool.h>
+
+#include "vm.h" // VirtualMachine
+
+// Writes what a VM keeps from one program to the next to `path`: its globals
+// and modules and every object they reach, chunks and strings included.
+// Objects refer to each other by number in the file, so it doesn't depend on
+// where anything was in memory. Fails if a program is suspended, or if an
+// object only makes sense inside a running program.
+bool snapshot_save(VirtualMachine* pVm, char const* path);
+
+// Restores a snapshot written by the same build of clox into `pVm`, which
+// must be fresh from vm_new_alloc(). The file is mapped and the objects are
+// rebuilt straight from it, nothing is compiled or run. On failure the VM is
+// left half restored and has to be freed.
+bool snapshot_load(VirtualMachine* pVm, char const* path);
+
+#endif // !CLOX_SNAPSHOT_H
@@ -35,6 +35,7 @@ typedef enum {
     TOKEN_FOR,
     TOKEN_FUN,
     TOKEN_IF,
+    TOKEN_IMPORT,
     TOKEN_NIL,
     TOKEN_OR,
     TOKEN_PRINT,
@@ -54,6 +55,8 @@ typedef struct {
     const char* start;
     int length;
     int line;
+    // Value of a TOKEN_NUMBER, converted by the scanner.
+    double number;
 } Token;
 
 #endif // !CLOX_TOKEN_H
@@ -1,13 +1,17 @@
 #include "value.h"
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
-#include <stdio.h>
-#include <stdlib.h>
+
+#include "memory.h" // memory_*
+#include "object.h" // object_*
+#include "output.h" // Output, output_*
 
 ValueVector value_vector_new_alloc(void) {
-    Value* values = malloc(sizeof(*values) * CLOX_VALUE_VECTOR_MIN_CAPACITY);
-    assert(values != NULL);
+    Value* values =
+        memory_reallocate(MEMORY_constants, NULL, 0,
+                          sizeof(*values) * CLOX_VALUE_VECTOR_MIN_CAPACITY);
     return (ValueVector){.values = values,
                          .capacity = CLOX_VALUE_VECTOR_MIN_CAPACITY,
                          .count = 0};
@@ -16,8 +20,9 @@ ValueVector value_vector_new_alloc(void) {
 void value_vector_free(ValueVector* pValueVector) {
     assert(pValueVector != NULL);
     assert(pValueVector->values != NULL);
-    free(pValueVector->values);
-    pValueVector->values = NULL;
+    pValueVector->values = memory_reallocate(
+        MEMORY_constants, pValueVector->values,
+        sizeof(*pValueVector->values) * pValueVector->capacity, 0);
 }
 
 ValueVector value_vector_push(ValueVector const values_vector,
@@ -30,9 +35,10 @@ ValueVector value_vector_push(ValueVector const values_vector,
         new_capacity = (values_vector.capacity < CLOX_VALUE_VECTOR_MIN_CAPACITY
                             ? CLOX_VALUE_VECTOR_MIN_CAPACITY
                             : values_vector.capacity * 2);
-        new_values = realloc(values_vector.values,
-                             sizeof(*values_vector.values) * new_capacity);
-        assert(new_values != NULL);
+        new_values = memory_reallocate(
+            MEMORY_constants, values_vector.values,
+            sizeof(*values_vector.values) * values_vector.capacity,
+            sizeof(*values_vector.values) * new_capacity);
     }
     new_values[values_vector.count] = value;
     return (ValueVector){.values = new_values,
@@ -40,4 +46,40 @@ ValueVector value_vector_push(ValueVector const values_vector,
                          .count = values_vector.count + 1};
 }
 
-void value_print(const Value value) { printf("%g", value); }
+bool value_equal(Value const a, Value const b) {
+    if (a.type != b.type) {
+        return false;
+    }
+    switch (a.type) {
+    case VALUE_nil:
+    case VALUE_undefined:
+        return true;
+    case VALUE_bool:
+        return VALUE_AS_BOOL(a) == VALUE_AS_BOOL(b);
+    case VALUE_number:
+        return VALUE_AS_NUMBER(a) == VALUE_AS_NUMBER(b);
+    case VALUE_object:
+        return VALUE_AS_OBJECT(a) == VALUE_AS_OBJECT(b);
+    }
+    return false; // Unreachable.
+}
+
+void value_print(Output* pOutput, const Value value) {
+    switch (value.type) {
+    case VALUE_nil:
+        output_write_string(pOutput, "nil");
+        break;
+    case VALUE_bool:
+        output_write_string(pOutput, VALUE_AS_BOOL(value) ? "true" : "false");
+        break;
+    case VALUE_number:
+        output_write_number(pOutput, VALUE_AS_NUMBER(value));
+        break;
+    case VALUE_object:
+        object_print(pOutput, VALUE_AS_OBJECT(value));
+        break;
+    case VALUE_undefined:
+        output_write_string(pOutput, "<undefined>");
+        break;
+    }
+}
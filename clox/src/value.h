@@ -1,11 +1,51 @@
 #ifndef CLOX_VALUE_H
 #define CLOX_VALUE_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
+#include "output.h" // Output
+
 #define CLOX_VALUE_VECTOR_MIN_CAPACITY 8
 
-typedef double Value;
+typedef struct Object Object;
+
+typedef enum {
+    VALUE_nil,
+    VALUE_bool,
+    VALUE_number,
+    VALUE_object,
+    // Held by global slots that the compiler handed out but that were not
+    // defined yet. Lox code can never observe it.
+    VALUE_undefined
+} ValueType;
+
+typedef struct {
+    ValueType type;
+    union {
+        bool boolean;
+        double number;
+        Object* object;
+    } as;
+} Value;
+
+#define VALUE_IS_NIL(value) ((value).type == VALUE_nil)
+#define VALUE_IS_BOOL(value) ((value).type == VALUE_bool)
+#define VALUE_IS_NUMBER(value) ((value).type == VALUE_number)
+#define VALUE_IS_OBJECT(value) ((value).type == VALUE_object)
+#define VALUE_IS_UNDEFINED(value) ((value).type == VALUE_undefined)
+
+#define VALUE_AS_BOOL(value) ((value).as.boolean)
+#define VALUE_AS_NUMBER(value) ((value).as.number)
+#define VALUE_AS_OBJECT(value) ((value).as.object)
+
+#define VALUE_NIL ((Value){.type = VALUE_nil, .as = {.number = 0}})
+#define VALUE_UNDEFINED                                                        \
+    ((Value){.type = VALUE_undefined, .as = {.number = 0}})
+#define VALUE_BOOL(b) ((Value){.type = VALUE_bool, .as = {.boolean = (b)}})
+#define VALUE_NUMBER(n) ((Value){.type = VALUE_number, .as = {.number = (n)}})
+#define VALUE_OBJECT(o)                                                        \
+    ((Value){.type = VALUE_object, .as = {.object = (Object*)(o)}})
 
 typedef struct {
     Value* values;
@@ -21,6 +61,9 @@ ValueVector value_vector_push(ValueVector const values_vector,
                               Value const value)
     __attribute__((warn_unused_result));
 
-void value_print(Value const value);
+// Lox's `==`. Strings are interned, so objects are only equal to themselves.
+bool value_equal(Value const a, Value const b);
+
+void value_print(Output* pOutput, Value const value);
 
 #endif // !CLOX_VALUE_H
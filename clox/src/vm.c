@@ -1,103 +1,1195 @@
+// For clock_gettime().
+#define _POSIX_C_SOURCE 200112L
+
 #include "vm.h"
 
 #include <assert.h>
+#include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-#include "chunk.h"    // Chunk, OPCODE_*
-#include "compiler.h" // compiler_*
-#include "value.h"    // Value, value_*
+#include "allocator.h" // allocator_*
+#include "batch.h"     // BatchColumn, batch_*
+#include "cache.h"     // ChunkCache, chunk_cache_*
+#include "chunk.h"     // Chunk, OPCODE_*
+#include "compiler.h"  // compiler_*
+#include "gc.h"        // GarbageCollector, gc_*
+#include "global.h"    // GlobalTable, global_table_*
+#include "line.h"      // line_vector_*
+#include "memory.h"    // memory_*
+#include "module.h"    // Module, module_table_*
+#include "object.h"    // ObjectString, ObjectInstance, OBJECT_*, object_*
+#include "output.h"    // Output, output_*
+#include "scanner.h"   // Scanner, scanner_*
+#include "shape.h"     // Shape, ShapeCache, shape_*
+#include "value.h"     // Value, VALUE_*, value_*
 
+// Release builds, like the ones benchmarks are run with, don't trace.
+#ifndef NDEBUG
 #define CLOX_DEBUG_TRACE_EXECUTION
+#endif
 
 #ifdef CLOX_DEBUG_TRACE_EXECUTION
 #include "debug.h" // debug_*
 #endif
 
+static void reset_stack(VirtualMachine* pVm) {
+    assert(pVm != NULL);
+    ObjectFiber* main_fiber = pVm->main_fiber;
+    main_fiber->stack_top = main_fiber->stack;
+    main_fiber->frame_count = 0;
+    main_fiber->state = FIBER_running;
+    // Other fibers are abandoned, they are garbage once nothing refers to
+    // them.
+    pVm->fiber = main_fiber;
+    pVm->ready_head = NULL;
+    pVm->ready_tail = NULL;
+}
+
+static void mark_chunk(GarbageCollector* pGc, Chunk const* chunk) {
+    if (chunk->constants.values == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < chunk->constants.count; i++) {
+        gc_mark_value(pGc, chunk->constants.values[i]);
+    }
+}
+
+static void mark_roots(GarbageCollector* pGc, void* context) {
+    VirtualMachine* pVm = context;
+    // The running fiber is changed without barriers, so its stack is
+    // scanned here, which happens again right before sweeping.
+    ObjectFiber const* fiber = pVm->fiber;
+    if (fiber != NULL) {
+        gc_mark_object(pGc, (Object*)fiber);
+        for (Value* slot = fiber->stack; slot < fiber->stack_top; slot++) {
+            gc_mark_value(pGc, *slot);
+        }
+        for (int i = 0; i < fiber->frame_count; i++) {
+            gc_mark_object(pGc, (Object*)fiber->frames[i].function);
+        }
+    }
+    gc_mark_object(pGc, (Object*)pVm->main_fiber);
+    for (ObjectFiber* ready = pVm->ready_head; ready != NULL;
+         ready = ready->next_ready) {
+        gc_mark_object(pGc, &ready->object);
+    }
+    for (size_t i = 0; i < pVm->globals.count; i++) {
+        gc_mark_value(pGc, pVm->globals.values[i]);
+    }
+    shape_tree_mark(&pVm->shapes, pGc);
+    module_table_mark(&pVm->modules, pGc);
+    // The chunk is a root while it's being compiled and while it runs.
+    mark_chunk(pGc, &pVm->chunk);
+    for (size_t i = 0; i < CLOX_CHUNK_CACHE_CAPACITY; i++) {
+        if (pVm->cache.entries[i].last_used != 0) {
+            mark_chunk(pGc, &pVm->cache.entries[i].chunk);
+        }
+    }
+}
+
+// Hands what the program printed and the debug output to their descriptors,
+// before a message on stderr or when a run is done.
+static void flush(VirtualMachine* pVm) {
+    output_flush(&pVm->debug_output);
+    output_flush(&pVm->output);
+}
+
+__attribute__((format(printf, 2, 3))) static void
+runtime_error(VirtualMachine* pVm, char const* format, ...) {
+    // What was printed before the error comes before it.
+    flush(pVm);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputs("\n", stderr);
+
+    ObjectFiber const* fiber = pVm->fiber;
+    for (int i = fiber->frame_count - 1; i >= 0; i--) {
+        CallFrame const* frame = &fiber->frames[i];
+        size_t instruction = frame->ip - frame->chunk->code - 1;
+        int line = line_vector_get_line(frame->chunk->line_vector, instruction);
+        if (frame->function == NULL) {
+            fprintf(stderr, "[line %d] in script\n", line);
+        } else {
+            fprintf(stderr, "[line %d] in %s()\n", line,
+                    frame->function->name->chars);
+        }
+    }
+    reset_stack(pVm);
+}
+
 static void push(VirtualMachine* pVm, Value value) {
     assert(pVm != NULL);
-    assert(pVm->stack_top < pVm->stack + STACK_MAX);
-    *pVm->stack_top = value;
-    pVm->stack_top += 1;
+    ObjectFiber* fiber = pVm->fiber;
+    assert(fiber->stack_top < fiber->stack + fiber->stack_capacity);
+    *fiber->stack_top = value;
+    fiber->stack_top += 1;
 }
 
 static Value pop(VirtualMachine* pVm) {
     assert(pVm != NULL);
-    assert(pVm->stack_top >= pVm->stack);
-    pVm->stack_top -= 1;
-    return *pVm->stack_top;
+    ObjectFiber* fiber = pVm->fiber;
+    assert(fiber->stack_top > fiber->stack);
+    fiber->stack_top -= 1;
+    return *fiber->stack_top;
+}
+
+static Value peek(VirtualMachine const* pVm, int distance) {
+    assert(pVm != NULL);
+    ObjectFiber const* fiber = pVm->fiber;
+    assert(fiber->stack_top - distance > fiber->stack);
+    return fiber->stack_top[-1 - distance];
+}
+
+// nil and false are falsey, every other value is truthy.
+static bool is_falsey(Value const value) {
+    return VALUE_IS_NIL(value) ||
+           (VALUE_IS_BOOL(value) && !VALUE_AS_BOOL(value));
+}
+
+static void concatenate(VirtualMachine* pVm) {
+    // Operands stay on the stack until the result exists so that they are
+    // still reachable if the allocation advances the collector.
+    ObjectString const* b = OBJECT_AS_STRING(peek(pVm, 0));
+    ObjectString const* a = OBJECT_AS_STRING(peek(pVm, 1));
+    ObjectString* result = object_string_concatenate(&pVm->gc, a, b);
+    pop(pVm);
+    pop(pVm);
+    push(pVm, VALUE_OBJECT(result));
+}
+
+// Replaces a native's callee and arguments with its result.
+static void native_return(VirtualMachine* pVm, Value* arguments,
+                          Value const result) {
+    arguments[-1] = result;
+    pVm->fiber->stack_top = arguments;
+}
+
+// Makes `target` the running fiber. The one it replaces keeps its state, a
+// value is handed to it later through the top of its stack.
+static void switch_fiber(VirtualMachine* pVm, ObjectFiber* target) {
+    ObjectFiber* current = pVm->fiber;
+    if (current->state == FIBER_running) {
+        current->state = FIBER_suspended;
+    }
+    // It was pushed to without barriers while it was running.
+    gc_barrier_back(&pVm->gc, &current->object);
+    target->state = FIBER_running;
+    pVm->fiber = target;
+}
+
+static void schedule(VirtualMachine* pVm, ObjectFiber* fiber) {
+    fiber->next_ready = NULL;
+    if (pVm->ready_tail == NULL) {
+        pVm->ready_head = fiber;
+    } else {
+        pVm->ready_tail->next_ready = fiber;
+    }
+    pVm->ready_tail = fiber;
+}
+
+static ObjectFiber* next_ready(VirtualMachine* pVm) {
+    ObjectFiber* fiber = pVm->ready_head;
+    if (fiber != NULL) {
+        pVm->ready_head = fiber->next_ready;
+        if (pVm->ready_head == NULL) {
+            pVm->ready_tail = NULL;
+        }
+        fiber->next_ready = NULL;
+    }
+    return fiber;
+}
+
+// Gives `value` to a suspended fiber as the result of the call it stopped
+// in: resume(), yield() or a call to a scheduled fiber.
+static void deliver(VirtualMachine* pVm, ObjectFiber* fiber,
+                    Value const value) {
+    fiber->stack_top[-1] = value;
+    gc_write_barrier(&pVm->gc, &fiber->object, value);
+}
+
+// Called when the running fiber returned from its last frame. Returns false
+// when there is nothing left to run.
+static bool finish_fiber(VirtualMachine* pVm, Value const result) {
+    ObjectFiber* fiber = pVm->fiber;
+    fiber->state = FIBER_done;
+    ObjectFiber* caller = fiber->caller;
+    if (caller != NULL) {
+        fiber->caller = NULL;
+        switch_fiber(pVm, caller);
+        deliver(pVm, caller, result);
+        return true;
+    }
+    // Fibers run by the scheduler take turns without waiting on each other,
+    // so when the run queue is empty every one of them is done.
+    ObjectFiber* next = next_ready(pVm);
+    if (next == NULL) {
+        return false;
+    }
+    switch_fiber(pVm, next);
+    return true;
+}
+
+// fiber(function): creates a fiber to be run with resume().
+static bool native_fiber(VirtualMachine* pVm, int argument_count,
+                         Value* arguments) {
+    if (argument_count != 1 || !OBJECT_IS_FUNCTION(arguments[0]) ||
+        OBJECT_AS_FUNCTION(arguments[0])->arity != 0) {
+        runtime_error(pVm, "Expected a function without parameters.");
+        return false;
+    }
+    // The function stays on the stack while the fiber is allocated.
+    ObjectFiber* fiber =
+        object_fiber_new(&pVm->gc, OBJECT_AS_FUNCTION(arguments[0]));
+    native_return(pVm, arguments, VALUE_OBJECT(fiber));
+    return true;
+}
+
+// spawn(function): creates a fiber and hands it to the scheduler, which
+// runs it when the running fiber yields or finishes.
+static bool native_spawn(VirtualMachine* pVm, int argument_count,
+                         Value* arguments) {
+    if (!native_fiber(pVm, argument_count, arguments)) {
+        return false;
+    }
+    schedule(pVm, OBJECT_AS_FIBER(arguments[-1]));
+    return true;
+}
+
+// resume(fiber[, value]): runs `fiber` until it yields or returns, which
+// gives the result of resume(). `value` becomes the result of the yield()
+// the fiber is suspended in.
+static bool native_resume(VirtualMachine* pVm, int argument_count,
+                          Value* arguments) {
+    if (argument_count < 1 || argument_count > 2) {
+        runtime_error(pVm, "Expected 1 or 2 arguments but got %d.",
+                      argument_count);
+        return false;
+    }
+    if (!OBJECT_IS_FIBER(arguments[0])) {
+        runtime_error(pVm, "Can only resume fibers.");
+        return false;
+    }
+    ObjectFiber* fiber = OBJECT_AS_FIBER(arguments[0]);
+    Value const value = argument_count == 2 ? arguments[1] : VALUE_NIL;
+    if (fiber->state == FIBER_done) {
+        runtime_error(pVm, "Can't resume a finished fiber.");
+        return false;
+    }
+    // Fibers waiting for the one they resumed are still running, as are
+    // the ones in the run queue.
+    bool running = fiber->next_ready != NULL || fiber == pVm->ready_tail;
+    for (ObjectFiber const* active = pVm->fiber; active != NULL;
+         active = active->caller) {
+        running = running || active == fiber;
+    }
+    if (running) {
+        runtime_error(pVm, "Can't resume a fiber that's already running.");
+        return false;
+    }
+    // The result slot is filled in when the fiber yields or returns.
+    native_return(pVm, arguments, VALUE_NIL);
+    bool const is_new = fiber->state == FIBER_new;
+    fiber->caller = pVm->fiber;
+    switch_fiber(pVm, fiber);
+    if (!is_new) {
+        deliver(pVm, fiber, value);
+    }
+    return true;
+}
+
+// yield([value]): suspends the running fiber. A resumed fiber hands `value`
+// to its caller, any other one lets the next fiber in the run queue take a
+// turn and queues up behind it.
+static bool native_yield(VirtualMachine* pVm, int argument_count,
+                         Value* arguments) {
+    if (argument_count > 1) {
+        runtime_error(pVm, "Expected 0 or 1 arguments but got %d.",
+                      argument_count);
+        return false;
+    }
+    Value const value = argument_count == 1 ? arguments[0] : VALUE_NIL;
+    native_return(pVm, arguments, VALUE_NIL);
+    ObjectFiber* fiber = pVm->fiber;
+    ObjectFiber* caller = fiber->caller;
+    if (caller != NULL) {
+        fiber->caller = NULL;
+        switch_fiber(pVm, caller);
+        deliver(pVm, caller, value);
+        return true;
+    }
+    ObjectFiber* next = next_ready(pVm);
+    if (next != NULL) {
+        schedule(pVm, fiber);
+        switch_fiber(pVm, next);
+    }
+    return true;
+}
+
+// done(fiber): whether `fiber` returned from its function.
+static bool native_done(VirtualMachine* pVm, int argument_count,
+                        Value* arguments) {
+    if (argument_count != 1 || !OBJECT_IS_FIBER(arguments[0])) {
+        runtime_error(pVm, "Expected a fiber.");
+        return false;
+    }
+    bool const done = OBJECT_AS_FIBER(arguments[0])->state == FIBER_done;
+    native_return(pVm, arguments, VALUE_BOOL(done));
+    return true;
 }
 
-static InterpretResult run(VirtualMachine vm) {
-#define READ_BYTE() (*vm.ip++)
-#define READ_CONSTANT() (vm.chunk.constants.values[READ_BYTE()])
-#define BINARY_OP(op)                                                          \
+static struct {
+    char const* name;
+    NativeFn function;
+} const natives[] = {
+    {"fiber", native_fiber}, {"spawn", native_spawn},
+    {"resume", native_resume}, {"yield", native_yield},
+    {"done", native_done},
+};
+
+static void define_native(VirtualMachine* pVm, char const* name,
+                          NativeFn function) {
+    size_t const slot =
+        global_table_resolve(&pVm->globals, name, (int)strlen(name));
+    pVm->globals.values[slot] =
+        VALUE_OBJECT(object_native_new(&pVm->gc, function));
+}
+
+NativeFn vm_native(size_t const index) {
+    return index < sizeof(natives) / sizeof(natives[0])
+               ? natives[index].function
+               : NULL;
+}
+
+static bool check_arity(VirtualMachine* pVm, ObjectFunction const* function,
+                        uint8_t const argument_count) {
+    if (argument_count != function->arity) {
+        runtime_error(pVm, "Expected %d arguments but got %d.",
+                      function->arity, argument_count);
+        return false;
+    }
+    return true;
+}
+
+// The caller must have stored its `ip` in its frame, since a new frame, a
+// fiber switch and a runtime error all read it. The running fiber may be
+// another one afterwards, and its stack may have moved.
+static bool call_value(VirtualMachine* pVm, Value const callee,
+                       uint8_t const argument_count) {
+    ObjectFiber* fiber = pVm->fiber;
+    if (OBJECT_IS_FUNCTION(callee)) {
+        ObjectFunction* function = OBJECT_AS_FUNCTION(callee);
+        if (!check_arity(pVm, function, argument_count)) {
+            return false;
+        }
+        if (fiber->frame_count == CLOX_FRAMES_MAX) {
+            runtime_error(pVm, "Stack overflow.");
+            return false;
+        }
+        object_fiber_reserve_frame(&pVm->gc, fiber);
+        object_fiber_reserve_stack(&pVm->gc, fiber,
+                                   function->chunk.stack_size);
+        fiber->frames[fiber->frame_count] =
+            (CallFrame){.function = function,
+                        .chunk = &function->chunk,
+                        .ip = function->chunk.code,
+                        .slots = fiber->stack_top - argument_count - 1};
+        fiber->frame_count += 1;
+        return true;
+    }
+    if (OBJECT_IS_NATIVE(callee)) {
+        return OBJECT_AS_NATIVE(callee)->function(
+            pVm, argument_count, fiber->stack_top - argument_count);
+    }
+    if (!OBJECT_IS_CLASS(callee)) {
+        runtime_error(pVm, "Can only call functions and classes.");
+        return false;
+    }
+    if (argument_count != 0) {
+        runtime_error(pVm, "Expected 0 arguments but got %d.",
+                      argument_count);
+        return false;
+    }
+    // The class stays on the stack while the instance is allocated.
+    ObjectInstance* instance = object_instance_new(
+        &pVm->gc, OBJECT_AS_CLASS(callee), pVm->shapes.root);
+    fiber->stack_top[-1] = VALUE_OBJECT(instance);
+    return true;
+}
+
+static bool get_property(VirtualMachine* pVm, ObjectString const* name,
+                         ShapeCache* pCache) {
+    Value const receiver = peek(pVm, 0);
+    if (!OBJECT_IS_INSTANCE(receiver)) {
+        runtime_error(pVm, "Only instances have properties.");
+        return false;
+    }
+    ObjectInstance const* instance = OBJECT_AS_INSTANCE(receiver);
+    ShapeCacheEntry const* entry = shape_cache_find(pCache, instance->shape);
+    uint32_t slot;
+    if (entry != NULL) {
+        slot = entry->slot;
+    } else {
+        int64_t const found = shape_find(instance->shape, name);
+        if (found < 0) {
+            runtime_error(pVm, "Undefined property '%s'.", name->chars);
+            return false;
+        }
+        slot = (uint32_t)found;
+        shape_cache_add(pCache, instance->shape, instance->shape, slot);
+    }
+    pVm->fiber->stack_top[-1] = instance->fields[slot];
+    return true;
+}
+
+static bool set_property(VirtualMachine* pVm, ObjectString* name,
+                         ShapeCache* pCache) {
+    Value const receiver = peek(pVm, 1);
+    if (!OBJECT_IS_INSTANCE(receiver)) {
+        runtime_error(pVm, "Only instances have fields.");
+        return false;
+    }
+    ObjectInstance* instance = OBJECT_AS_INSTANCE(receiver);
+    ShapeCacheEntry const* entry = shape_cache_find(pCache, instance->shape);
+    Shape* target;
+    uint32_t slot;
+    if (entry != NULL) {
+        target = entry->target;
+        slot = entry->slot;
+    } else {
+        int64_t const found = shape_find(instance->shape, name);
+        if (found >= 0) {
+            target = instance->shape;
+            slot = (uint32_t)found;
+        } else {
+            target = shape_transition(instance->shape, name);
+            slot = target->field_count - 1;
+        }
+        shape_cache_add(pCache, instance->shape, target, slot);
+    }
+    // Both the instance and the value are still on the stack here.
+    object_instance_reserve(&pVm->gc, instance, target->field_count);
+    Value const value = peek(pVm, 0);
+    instance->fields[slot] = value;
+    instance->shape = target;
+    gc_write_barrier(&pVm->gc, &instance->object, value);
+    pVm->fiber->stack_top -= 1;
+    pVm->fiber->stack_top[-1] = value;
+    return true;
+}
+
+static uint64_t now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+// Hands out the next calls of the budget: the rest of it, or as many as may
+// run before the clock is read again.
+static void refuel(Budget* pBudget) {
+    uint64_t fuel =
+        pBudget->deadline != 0 ? CLOX_BUDGET_CLOCK_CALLS : UINT64_MAX;
+    if (pBudget->max_calls != 0) {
+        fuel = fuel < pBudget->calls ? fuel : pBudget->calls;
+        pBudget->calls -= fuel;
+    }
+    pBudget->fuel = fuel;
+}
+
+static void arm_budget(Budget* pBudget) {
+    pBudget->calls = pBudget->max_calls;
+    pBudget->deadline =
+        pBudget->max_nanoseconds != 0 ? now() + pBudget->max_nanoseconds : 0;
+    refuel(pBudget);
+}
+
+// Called by run() when the fuel is used up. Returns whether the budget is
+// spent, or else refuels.
+static bool budget_spent(Budget* pBudget) {
+    if (pBudget->max_calls != 0 && pBudget->calls == 0) {
+        return true;
+    }
+    if (pBudget->deadline != 0 && now() >= pBudget->deadline) {
+        return true;
+    }
+    refuel(pBudget);
+    return false;
+}
+
+static InterpretResult run(VirtualMachine* pVm) {
+    // The running frame's `ip` and slot base are kept in locals, so that
+    // they can live in registers. `ip` is stored back into the frame before
+    // anything that may read it, like a call or a runtime error. Calls may
+    // also switch fibers or move the running fiber's stack, so the locals
+    // are loaded again after them.
+    CallFrame* frame = &pVm->fiber->frames[pVm->fiber->frame_count - 1];
+    uint8_t* ip = frame->ip;
+    Value* slots = frame->slots;
+
+#define READ_BYTE() (*ip++)
+#define READ_SHORT() (ip += 2, (uint16_t)((ip[-2] << 8) | ip[-1]))
+#define READ_CONSTANT() (frame->chunk->constants.values[READ_BYTE()])
+#define SAVE_IP() (frame->ip = ip)
+#define LOAD_FRAME()                                                           \
+    (frame = &pVm->fiber->frames[pVm->fiber->frame_count - 1], ip = frame->ip, \
+     slots = frame->slots)
+#define RUNTIME_ERROR(...)                                                     \
+    do {                                                                       \
+        SAVE_IP();                                                             \
+        runtime_error(pVm, __VA_ARGS__);                                       \
+        return INTERPRET_RUNTIME_ERROR;                                        \
+    } while (false)
+#define BINARY_OP(value_type, op)                                              \
+    do {                                                                       \
+        if (!VALUE_IS_NUMBER(peek(pVm, 0)) ||                                  \
+            !VALUE_IS_NUMBER(peek(pVm, 1))) {                                  \
+            RUNTIME_ERROR("Operands must be numbers.");                        \
+        }                                                                      \
+        double b = VALUE_AS_NUMBER(pop(pVm));                                  \
+        double a = VALUE_AS_NUMBER(pop(pVm));                                  \
+        push(pVm, value_type(a op b));                                         \
+    } while (false)
+// Rewrites the instruction whose opcode was just read.
+#define QUICKEN(opcode) (ip[-1] = (opcode))
+// Rewrites it back to its generic form and has that executed instead.
+#define DEOPTIMIZE(opcode) (ip[-1] = (opcode), ip -= 1)
+#define BINARY_OP_LOCAL(value_type, op)                                        \
     do {                                                                       \
-        double b = pop(&vm);                                                   \
-        double a = pop(&vm);                                                   \
-        push(&vm, a op b);                                                     \
+        Value const b = slots[READ_BYTE()];                                    \
+        if (!VALUE_IS_NUMBER(b) || !VALUE_IS_NUMBER(peek(pVm, 0))) {           \
+            RUNTIME_ERROR("Operands must be numbers.");                        \
+        }                                                                      \
+        double a = VALUE_AS_NUMBER(pop(pVm));                                  \
+        push(pVm, value_type(a op VALUE_AS_NUMBER(b)));                        \
+    } while (false)
+// Pops the operands of a fused comparison, and jumps if `a op b` is `taken`.
+#define COMPARE_JUMP(op, taken)                                                \
+    do {                                                                       \
+        uint16_t const offset = READ_SHORT();                                  \
+        if (!VALUE_IS_NUMBER(peek(pVm, 0)) ||                                  \
+            !VALUE_IS_NUMBER(peek(pVm, 1))) {                                  \
+            RUNTIME_ERROR("Operands must be numbers.");                        \
+        }                                                                      \
+        double b = VALUE_AS_NUMBER(pop(pVm));                                  \
+        double a = VALUE_AS_NUMBER(pop(pVm));                                  \
+        if ((a op b) == (taken)) {                                             \
+            ip += offset;                                                      \
+        }                                                                      \
+    } while (false)
+#define EQUAL_JUMP(taken)                                                      \
+    do {                                                                       \
+        uint16_t const offset = READ_SHORT();                                  \
+        Value const b = pop(pVm);                                              \
+        Value const a = pop(pVm);                                              \
+        if (value_equal(a, b) == (taken)) {                                    \
+            ip += offset;                                                      \
+        }                                                                      \
+    } while (false)
+// Suspends the program before the call or loop whose opcode was just read
+// if the budget is spent.
+#define CHECK_BUDGET()                                                         \
+    do {                                                                       \
+        if (pVm->budget.fuel == 0 && budget_spent(&pVm->budget)) {            \
+            ip -= 1;                                                           \
+            SAVE_IP();                                                         \
+            return INTERPRET_SUSPENDED;                                        \
+        }                                                                      \
+        pVm->budget.fuel -= 1;                                                 \
     } while (false)
 
     for (;;) {
 #ifdef CLOX_DEBUG_TRACE_EXECUTION
-        printf("          ");
-        for (Value* slot = vm.stack; slot < vm.stack_top; slot++) {
-            printf("[ ");
-            value_print(*slot);
-            printf(" ]");
-        }
-        printf("\n");
-        debug_disassemble_instruction(&vm.chunk, vm.ip - vm.chunk.code);
+        output_write_string(&pVm->debug_output, "          ");
+        for (Value* slot = pVm->fiber->stack; slot < pVm->fiber->stack_top;
+             slot++) {
+            output_write_string(&pVm->debug_output, "[ ");
+            value_print(&pVm->debug_output, *slot);
+            output_write_string(&pVm->debug_output, " ]");
+        }
+        output_write_char(&pVm->debug_output, '\n');
+        debug_disassemble_instruction(&pVm->debug_output, frame->chunk,
+                                      ip - frame->chunk->code);
 #endif
         uint8_t instruction;
         switch (instruction = READ_BYTE()) {
         case OPCODE_constant: {
             Value constant = READ_CONSTANT();
-            push(&vm, constant);
+            push(pVm, constant);
+            break;
+        }
+        case OPCODE_nil:
+            push(pVm, VALUE_NIL);
+            break;
+        case OPCODE_true:
+            push(pVm, VALUE_BOOL(true));
+            break;
+        case OPCODE_false:
+            push(pVm, VALUE_BOOL(false));
+            break;
+        case OPCODE_pop:
+            pop(pVm);
+            break;
+        case OPCODE_define_global: {
+            uint16_t slot = READ_SHORT();
+            pVm->globals.values[slot] = pop(pVm);
+            break;
+        }
+        case OPCODE_get_global: {
+            uint16_t slot = READ_SHORT();
+            Value value = pVm->globals.values[slot];
+            if (VALUE_IS_UNDEFINED(value)) {
+                RUNTIME_ERROR("Undefined variable '%s'.",
+                              pVm->globals.names[slot].chars);
+            }
+            push(pVm, value);
             break;
         }
+        case OPCODE_set_global: {
+            uint16_t slot = READ_SHORT();
+            if (VALUE_IS_UNDEFINED(pVm->globals.values[slot])) {
+                RUNTIME_ERROR("Undefined variable '%s'.",
+                              pVm->globals.names[slot].chars);
+            }
+            pVm->globals.values[slot] = peek(pVm, 0);
+            break;
+        }
+        case OPCODE_get_local:
+            push(pVm, slots[READ_BYTE()]);
+            break;
+        case OPCODE_get_local_0:
+            push(pVm, slots[0]);
+            break;
+        case OPCODE_get_local_1:
+            push(pVm, slots[1]);
+            break;
+        case OPCODE_get_local_2:
+            push(pVm, slots[2]);
+            break;
+        case OPCODE_get_local_3:
+            push(pVm, slots[3]);
+            break;
+        case OPCODE_set_local:
+            slots[READ_BYTE()] = peek(pVm, 0);
+            break;
         case OPCODE_add:
-            BINARY_OP(+);
+            if (OBJECT_IS_STRING(peek(pVm, 0)) &&
+                OBJECT_IS_STRING(peek(pVm, 1))) {
+                QUICKEN(OPCODE_add_str_str);
+                concatenate(pVm);
+            } else if (VALUE_IS_NUMBER(peek(pVm, 0)) &&
+                       VALUE_IS_NUMBER(peek(pVm, 1))) {
+                QUICKEN(OPCODE_add_num_num);
+                double b = VALUE_AS_NUMBER(pop(pVm));
+                double a = VALUE_AS_NUMBER(pop(pVm));
+                push(pVm, VALUE_NUMBER(a + b));
+            } else {
+                RUNTIME_ERROR("Operands must be two numbers or two strings.");
+            }
             break;
         case OPCODE_subtract:
-            BINARY_OP(-);
+            BINARY_OP(VALUE_NUMBER, -);
             break;
         case OPCODE_multiply:
-            BINARY_OP(*);
+            BINARY_OP(VALUE_NUMBER, *);
             break;
         case OPCODE_divide:
-            BINARY_OP(/);
+            BINARY_OP(VALUE_NUMBER, /);
             break;
         case OPCODE_negate:
-            push(&vm, -pop(&vm));
+            if (!VALUE_IS_NUMBER(peek(pVm, 0))) {
+                RUNTIME_ERROR("Operand must be a number.");
+            }
+            push(pVm, VALUE_NUMBER(-VALUE_AS_NUMBER(pop(pVm))));
+            break;
+        case OPCODE_not:
+            push(pVm, VALUE_BOOL(is_falsey(pop(pVm))));
+            break;
+        case OPCODE_equal: {
+            Value const b = pop(pVm);
+            Value const a = pop(pVm);
+            push(pVm, VALUE_BOOL(value_equal(a, b)));
+            break;
+        }
+        case OPCODE_greater:
+            BINARY_OP(VALUE_BOOL, >);
+            break;
+        case OPCODE_less:
+            BINARY_OP(VALUE_BOOL, <);
+            break;
+        case OPCODE_add_local: {
+            // The operand is skipped last, QUICKEN() needs `ip` past the
+            // opcode only.
+            Value const b = slots[ip[0]];
+            if (OBJECT_IS_STRING(b) && OBJECT_IS_STRING(peek(pVm, 0))) {
+                QUICKEN(OPCODE_add_local_str_str);
+                push(pVm, b);
+                concatenate(pVm);
+            } else if (VALUE_IS_NUMBER(b) && VALUE_IS_NUMBER(peek(pVm, 0))) {
+                QUICKEN(OPCODE_add_local_num_num);
+                double a = VALUE_AS_NUMBER(pop(pVm));
+                push(pVm, VALUE_NUMBER(a + VALUE_AS_NUMBER(b)));
+            } else {
+                RUNTIME_ERROR("Operands must be two numbers or two strings.");
+            }
+            ip += 1;
+            break;
+        }
+        case OPCODE_subtract_local:
+            BINARY_OP_LOCAL(VALUE_NUMBER, -);
+            break;
+        case OPCODE_multiply_local:
+            BINARY_OP_LOCAL(VALUE_NUMBER, *);
+            break;
+        case OPCODE_divide_local:
+            BINARY_OP_LOCAL(VALUE_NUMBER, /);
+            break;
+        case OPCODE_add_num_num: {
+            Value const b = peek(pVm, 0);
+            Value const a = peek(pVm, 1);
+            if (!VALUE_IS_NUMBER(a) || !VALUE_IS_NUMBER(b)) {
+                DEOPTIMIZE(OPCODE_add);
+                break;
+            }
+            pVm->fiber->stack_top -= 1;
+            pVm->fiber->stack_top[-1] =
+                VALUE_NUMBER(VALUE_AS_NUMBER(a) + VALUE_AS_NUMBER(b));
+            break;
+        }
+        case OPCODE_add_str_str:
+            if (!OBJECT_IS_STRING(peek(pVm, 0)) ||
+                !OBJECT_IS_STRING(peek(pVm, 1))) {
+                DEOPTIMIZE(OPCODE_add);
+                break;
+            }
+            concatenate(pVm);
+            break;
+        case OPCODE_add_local_num_num: {
+            // The guard runs before the operand is read, so that a failing
+            // one leaves `ip` on the opcode.
+            Value const b = slots[ip[0]];
+            Value const a = peek(pVm, 0);
+            if (!VALUE_IS_NUMBER(a) || !VALUE_IS_NUMBER(b)) {
+                DEOPTIMIZE(OPCODE_add_local);
+                break;
+            }
+            ip += 1;
+            pVm->fiber->stack_top[-1] =
+                VALUE_NUMBER(VALUE_AS_NUMBER(a) + VALUE_AS_NUMBER(b));
+            break;
+        }
+        case OPCODE_add_local_str_str: {
+            Value const b = slots[ip[0]];
+            if (!OBJECT_IS_STRING(b) || !OBJECT_IS_STRING(peek(pVm, 0))) {
+                DEOPTIMIZE(OPCODE_add_local);
+                break;
+            }
+            ip += 1;
+            push(pVm, b);
+            concatenate(pVm);
+            break;
+        }
+        case OPCODE_jump: {
+            uint16_t const offset = READ_SHORT();
+            ip += offset;
+            break;
+        }
+        case OPCODE_loop: {
+            CHECK_BUDGET();
+            uint16_t const offset = READ_SHORT();
+            ip -= offset;
+            break;
+        }
+        case OPCODE_jump_if_false: {
+            uint16_t const offset = READ_SHORT();
+            if (is_falsey(pop(pVm))) {
+                ip += offset;
+            }
+            break;
+        }
+        case OPCODE_jump_if_false_or_pop: {
+            uint16_t const offset = READ_SHORT();
+            if (is_falsey(peek(pVm, 0))) {
+                ip += offset;
+            } else {
+                pop(pVm);
+            }
+            break;
+        }
+        case OPCODE_jump_if_true_or_pop: {
+            uint16_t const offset = READ_SHORT();
+            if (!is_falsey(peek(pVm, 0))) {
+                ip += offset;
+            } else {
+                pop(pVm);
+            }
+            break;
+        }
+        case OPCODE_jump_if_equal:
+            EQUAL_JUMP(true);
+            break;
+        case OPCODE_jump_if_not_equal:
+            EQUAL_JUMP(false);
+            break;
+        case OPCODE_jump_if_greater:
+            COMPARE_JUMP(>, true);
+            break;
+        case OPCODE_jump_if_not_greater:
+            COMPARE_JUMP(>, false);
+            break;
+        case OPCODE_jump_if_less:
+            COMPARE_JUMP(<, true);
+            break;
+        case OPCODE_jump_if_not_less:
+            COMPARE_JUMP(<, false);
+            break;
+        case OPCODE_class: {
+            // The name is a constant, so it's reachable while the class is
+            // allocated.
+            ObjectClass* klass = object_class_new(
+                &pVm->gc, OBJECT_AS_STRING(READ_CONSTANT()));
+            push(pVm, VALUE_OBJECT(klass));
             break;
+        }
+        case OPCODE_call: {
+            CHECK_BUDGET();
+            uint8_t const argument_count = READ_BYTE();
+            SAVE_IP();
+            if (!call_value(pVm, peek(pVm, argument_count), argument_count)) {
+                return INTERPRET_RUNTIME_ERROR;
+            }
+            LOAD_FRAME();
+            break;
+        }
+        case OPCODE_tail_call: {
+            CHECK_BUDGET();
+            uint8_t const argument_count = READ_BYTE();
+            Value const callee = peek(pVm, argument_count);
+            SAVE_IP();
+            if (!OBJECT_IS_FUNCTION(callee)) {
+                // The `return` that follows passes the result on.
+                if (!call_value(pVm, callee, argument_count)) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                LOAD_FRAME();
+                break;
+            }
+            ObjectFunction* function = OBJECT_AS_FUNCTION(callee);
+            if (!check_arity(pVm, function, argument_count)) {
+                return INTERPRET_RUNTIME_ERROR;
+            }
+            // The callee and its arguments take over the caller's slots, so
+            // the frame is reused and recursion in tail position runs in
+            // constant space.
+            ObjectFiber* fiber = pVm->fiber;
+            object_fiber_reserve_stack(&pVm->gc, fiber,
+                                       function->chunk.stack_size);
+            slots = frame->slots;
+            Value* arguments = fiber->stack_top - argument_count - 1;
+            memmove(slots, arguments,
+                    sizeof(*arguments) * ((size_t)argument_count + 1));
+            fiber->stack_top = slots + argument_count + 1;
+            frame->function = function;
+            frame->chunk = &function->chunk;
+            ip = function->chunk.code;
+            break;
+        }
+        case OPCODE_get_property: {
+            ObjectString const* name = OBJECT_AS_STRING(READ_CONSTANT());
+            ShapeCache* cache = &frame->chunk->shape_caches[READ_SHORT()];
+            SAVE_IP();
+            if (!get_property(pVm, name, cache)) {
+                return INTERPRET_RUNTIME_ERROR;
+            }
+            break;
+        }
+        case OPCODE_set_property: {
+            ObjectString* name = OBJECT_AS_STRING(READ_CONSTANT());
+            ShapeCache* cache = &frame->chunk->shape_caches[READ_SHORT()];
+            SAVE_IP();
+            if (!set_property(pVm, name, cache)) {
+                return INTERPRET_RUNTIME_ERROR;
+            }
+            break;
+        }
+        case OPCODE_print:
+            value_print(&pVm->output, pop(pVm));
+            output_write_char(&pVm->output, '\n');
+            break;
+        case OPCODE_import: {
+            CHECK_BUDGET();
+            uint16_t const slot = READ_SHORT();
+            Module* module = &pVm->modules.modules[slot];
+            if (module->ran) {
+                push(pVm, VALUE_NIL);
+                break;
+            }
+            // Loading it failed since the code was compiled.
+            if (module->function == NULL) {
+                RUNTIME_ERROR("Module \"%s\" isn't loaded.",
+                              pVm->modules.paths.names[slot].chars);
+            }
+            // Marked first, so that modules importing each other stop.
+            module->ran = true;
+            push(pVm, VALUE_OBJECT(module->function));
+            SAVE_IP();
+            if (!call_value(pVm, peek(pVm, 0), 0)) {
+                return INTERPRET_RUNTIME_ERROR;
+            }
+            LOAD_FRAME();
+            break;
+        }
         case OPCODE_return: {
-            value_print(pop(&vm));
-            printf("\n");
-            return INTERPRET_OK;
+            Value const result = pop(pVm);
+            ObjectFiber* fiber = pVm->fiber;
+            fiber->frame_count -= 1;
+            fiber->stack_top = frame->slots;
+            if (fiber->frame_count == 0) {
+                if (!finish_fiber(pVm, result)) {
+                    return INTERPRET_OK;
+                }
+            } else {
+                push(pVm, result);
+            }
+            LOAD_FRAME();
+            break;
         }
         }
     }
 
 #undef READ_BYTE
+#undef READ_SHORT
 #undef READ_CONSTANT
+#undef SAVE_IP
+#undef LOAD_FRAME
+#undef RUNTIME_ERROR
 #undef BINARY_OP
+#undef QUICKEN
+#undef DEOPTIMIZE
+#undef BINARY_OP_LOCAL
+#undef COMPARE_JUMP
+#undef EQUAL_JUMP
+#undef CHECK_BUDGET
+}
+
+VirtualMachine* vm_new_alloc(void) {
+    VirtualMachine* pVm =
+        memory_reallocate(MEMORY_vm, NULL, 0, sizeof(*pVm));
+    pVm->chunk = (Chunk){0};
+    pVm->fiber = NULL;
+    pVm->main_fiber = NULL;
+    pVm->ready_head = NULL;
+    pVm->ready_tail = NULL;
+    pVm->globals = global_table_new_alloc();
+    pVm->modules = module_table_new_alloc();
+    pVm->allocator = allocator_new();
+    pVm->gc = gc_new(&pVm->allocator, mark_roots, pVm);
+    pVm->shapes = shape_tree_new_alloc();
+    pVm->output = output_new_alloc(STDOUT_FILENO);
+    pVm->debug_output = output_new_alloc(STDERR_FILENO);
+    pVm->cache = chunk_cache_new();
+    pVm->budget = (Budget){0};
+    pVm->suspended = false;
+    pVm->owns_chunk = false;
+    arm_budget(&pVm->budget);
+    // The script runs on the main fiber, which other fibers are resumed
+    // from.
+    pVm->main_fiber = object_fiber_new(&pVm->gc, NULL);
+    reset_stack(pVm);
+    for (size_t i = 0; i < sizeof(natives) / sizeof(natives[0]); i++) {
+        define_native(pVm, natives[i].name, natives[i].function);
+    }
+    return pVm;
+}
+
+void vm_free(VirtualMachine* pVm) {
+    assert(pVm != NULL);
+    if (pVm->suspended) {
+        vm_cancel(pVm);
+    }
+    output_free(&pVm->output);
+    output_free(&pVm->debug_output);
+    // Frees the chunks before the objects their constants point to.
+    chunk_cache_free(&pVm->cache);
+    gc_free(&pVm->gc);
+    shape_tree_free(&pVm->shapes);
+    allocator_free(&pVm->allocator);
+    global_table_free(&pVm->globals);
+    module_table_free(&pVm->modules);
+    memory_reallocate(MEMORY_vm, pVm, sizeof(*pVm), 0);
+}
+
+// Runs the VM's chunk as the script.
+static InterpretResult run_script(VirtualMachine* pVm) {
+    ObjectFiber* fiber = pVm->main_fiber;
+    // Slot 0 of the script's frame has no callee.
+    push(pVm, VALUE_NIL);
+    object_fiber_reserve_stack(&pVm->gc, fiber, pVm->chunk.stack_size);
+    fiber->frames[0] = (CallFrame){.function = NULL,
+                                   .chunk = &pVm->chunk,
+                                   .ip = pVm->chunk.code,
+                                   .slots = fiber->stack};
+    fiber->frame_count = 1;
+    arm_budget(&pVm->budget);
+    return run(pVm);
+}
+
+static void drop_program(VirtualMachine* pVm) {
+    if (pVm->owns_chunk) {
+        chunk_free(&pVm->chunk);
+    }
+    pVm->chunk = (Chunk){0};
+    pVm->owns_chunk = false;
+    reset_stack(pVm);
+}
+
+// Drops the program once a run is done with it. A suspended one is kept,
+// but what it printed so far is flushed all the same.
+static InterpretResult end_run(VirtualMachine* pVm,
+                               InterpretResult const result) {
+    flush(pVm);
+    pVm->suspended = result == INTERPRET_SUSPENDED;
+    if (!pVm->suspended) {
+        drop_program(pVm);
+    }
+    return result;
+}
+
+void vm_set_budget(VirtualMachine* pVm, uint64_t const max_calls,
+                   uint64_t const max_nanoseconds) {
+    assert(pVm != NULL);
+    pVm->budget.max_calls = max_calls;
+    pVm->budget.max_nanoseconds = max_nanoseconds;
+    arm_budget(&pVm->budget);
+}
+
+InterpretResult vm_resume(VirtualMachine* pVm) {
+    assert(pVm != NULL && pVm->suspended);
+    arm_budget(&pVm->budget);
+    return end_run(pVm, run(pVm));
+}
+
+void vm_cancel(VirtualMachine* pVm) {
+    assert(pVm != NULL && pVm->suspended);
+    pVm->suspended = false;
+    drop_program(pVm);
+}
+
+// Compiles the program into the VM's chunk, then loads the modules it
+// imports.
+static bool compile(VirtualMachine* pVm, Scanner* pScanner) {
+    return compiler_compile(pScanner, &pVm->chunk, &pVm->gc, &pVm->globals,
+                            &pVm->modules, &pVm->debug_output) &&
+           module_table_load(&pVm->modules, &pVm->gc, &pVm->globals,
+                             &pVm->debug_output, 0);
 }
 
-InterpretResult vm_interpret(char const* const source) {
-    Chunk chunk = chunk_new_alloc();
+static InterpretResult interpret(VirtualMachine* pVm, Scanner* pScanner) {
+    assert(pVm != NULL && !pVm->suspended);
+    pVm->chunk = chunk_new_alloc();
+    pVm->owns_chunk = true;
+    if (!compile(pVm, pScanner)) {
+        return end_run(pVm, INTERPRET_COMPILE_ERROR);
+    }
+    chunk_freeze(&pVm->chunk);
+    return end_run(pVm, run_script(pVm));
+}
+
+InterpretResult vm_interpret(VirtualMachine* pVm, char const* const source) {
+    Scanner scanner = scanner_new(source);
+    return interpret(pVm, &scanner);
+}
 
-    if (!compiler_compile(source, &chunk)) {
-        chunk_free(&chunk);
-        return INTERPRET_COMPILE_ERROR;
+InterpretResult vm_interpret_cached(VirtualMachine* pVm,
+                                    char const* const source) {
+    assert(pVm != NULL && !pVm->suspended);
+    size_t const length = strlen(source);
+    Chunk* cached = chunk_cache_find(&pVm->cache, source, length);
+    if (cached == NULL) {
+        pVm->chunk = chunk_new_alloc();
+        Scanner scanner = scanner_new(source);
+        if (!compile(pVm, &scanner)) {
+            flush(pVm);
+            chunk_free(&pVm->chunk);
+            pVm->chunk = (Chunk){0};
+            return INTERPRET_COMPILE_ERROR;
+        }
+        chunk_freeze(&pVm->chunk);
+        cached = chunk_cache_insert(&pVm->cache, source, length, pVm->chunk);
     }
 
-    Value stack[STACK_MAX];
-    VirtualMachine vm = {
-        .chunk = chunk, .ip = chunk.code, .stack = stack, .stack_top = stack};
+    // Borrowed from the cache, which stays its owner. Quickened instructions
+    // are kept for the next run.
+    pVm->chunk = *cached;
+    pVm->owns_chunk = false;
+    return end_run(pVm, run_script(pVm));
+}
+
+InterpretResult vm_interpret_stream(VirtualMachine* pVm, FILE* input) {
+    Scanner scanner = scanner_new_stream_alloc(input);
+    InterpretResult const result = interpret(pVm, &scanner);
+    scanner_free(&scanner);
+    return result;
+}
+
+InterpretResult vm_interpret_parallel(VirtualMachine* pVm,
+                                      char const* const source,
+                                      size_t const length) {
+    Scanner scanner = scanner_new_parallel_alloc(source, length, 0);
+    InterpretResult const result = interpret(pVm, &scanner);
+    scanner_free(&scanner);
+    return result;
+}
+
+InterpretResult vm_evaluate_batch(VirtualMachine* pVm, char const* expression,
+                                  BatchColumn const* columns,
+                                  size_t const column_count, size_t const rows,
+                                  double* results) {
+    assert(pVm != NULL && !pVm->suspended);
+    pVm->chunk = chunk_new_alloc();
+    Scanner scanner = scanner_new(expression);
+    InterpretResult result = INTERPRET_COMPILE_ERROR;
+    if (compiler_compile_expression(&scanner, &pVm->chunk, &pVm->gc,
+                                    &pVm->globals, &pVm->debug_output)) {
+        chunk_freeze(&pVm->chunk);
+        // Columns are looked up by the global slot the compiler resolved
+        // their name to. Columns the expression doesn't mention get a slot
+        // first, so that the table's size is final.
+        for (size_t i = 0; i < column_count; i++) {
+            global_table_resolve(&pVm->globals, columns[i].name,
+                                 (int)strlen(columns[i].name));
+        }
+        size_t const slot_count = pVm->globals.count;
+        double const** by_slot = memory_reallocate(
+            MEMORY_vm, NULL, 0, sizeof(*by_slot) * slot_count);
+        for (size_t slot = 0; slot < slot_count; slot++) {
+            by_slot[slot] = NULL;
+        }
+        for (size_t i = 0; i < column_count; i++) {
+            size_t const slot = global_table_resolve(
+                &pVm->globals, columns[i].name, (int)strlen(columns[i].name));
+            by_slot[slot] = columns[i].values;
+        }
 
-    InterpretResult result = run(vm);
+        if (batch_can_run(&pVm->chunk, by_slot, slot_count)) {
+            batch_run(&pVm->chunk, by_slot, rows, results);
+            result = INTERPRET_OK;
+        } else {
+            flush(pVm);
+            fputs("Expression can't be evaluated in batch.\n", stderr);
+            result = INTERPRET_RUNTIME_ERROR;
+        }
+        memory_reallocate(MEMORY_vm, by_slot,
+                          sizeof(*by_slot) * slot_count, 0);
+    }
 
-    chunk_free(&chunk);
+    flush(pVm);
+    chunk_free(&pVm->chunk);
+    pVm->chunk = (Chunk){0};
     return result;
 }
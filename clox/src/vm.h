@@ -2,26 +2,127 @@
 #define CLOX_VM_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
-#include "chunk.h" // Chunk
-#include "value.h" // Value
+#include "allocator.h" // Allocator
+#include "batch.h"     // BatchColumn
+#include "cache.h"     // ChunkCache
+#include "chunk.h"     // Chunk
+#include "gc.h"        // GarbageCollector
+#include "global.h"    // GlobalTable
+#include "module.h"    // ModuleTable
+#include "object.h"    // ObjectFiber
+#include "output.h"    // Output
+#include "shape.h"     // ShapeTree
+#include "value.h"     // Value
 
-#define STACK_MAX 256
+// Frames a single fiber may have.
+#define CLOX_FRAMES_MAX 256
 
+// Calls between two readings of the clock when a run has a time limit.
+#define CLOX_BUDGET_CLOCK_CALLS 1024
+
+// How much a run may do before the program is suspended. Only calls and
+// loops count: every other jump goes forwards, so the rest of a chunk runs
+// at most once per call or time round a loop.
 typedef struct {
+    // Limits of every run, 0 for none.
+    uint64_t max_calls;
+    uint64_t max_nanoseconds;
+    // Calls until run() looks at the budget again. Without limits it never
+    // gets there, which leaves a decrement per call.
+    uint64_t fuel;
+    // Calls left once `fuel` is used up.
+    uint64_t calls;
+    // CLOCK_MONOTONIC time in nanoseconds the run ends at, 0 for none.
+    uint64_t deadline;
+} Budget;
+
+typedef struct VirtualMachine {
     Chunk chunk;
-    uint8_t* ip;
-    Value* stack;
-    Value* stack_top;
+    // Fiber whose stack and frames are being run.
+    ObjectFiber* fiber;
+    // Fiber the script runs on, reused by every program.
+    ObjectFiber* main_fiber;
+    // Fibers waiting for the scheduler, in the order they're run.
+    ObjectFiber* ready_head;
+    ObjectFiber* ready_tail;
+    GlobalTable globals;
+    ModuleTable modules;
+    Allocator allocator;
+    GarbageCollector gc;
+    // Shared by the instances of every class.
+    ShapeTree shapes;
+    // Standard output, flushed when the VM is done with a program.
+    Output output;
+    // Standard error, for the disassembly of code that failed to compile and
+    // the execution trace, so that standard output only has what programs
+    // print. Flushed along with `output`.
+    Output debug_output;
+    // Chunks of vm_interpret_cached(), their constants are roots.
+    ChunkCache cache;
+    Budget budget;
+    // A program ran out of its budget and waits for vm_resume(). Its chunk
+    // is freed when it's done if the VM compiled it, not if it's cached.
+    bool suspended;
+    bool owns_chunk;
 } VirtualMachine;
 
 typedef enum {
     INTERPRET_OK,
     INTERPRET_COMPILE_ERROR,
-    INTERPRET_RUNTIME_ERROR
+    INTERPRET_RUNTIME_ERROR,
+    INTERPRET_SUSPENDED
 } InterpretResult;
 
-InterpretResult vm_interpret(char const* const source);
+// Creates a VM with the natives defined, which take the first global slots.
+VirtualMachine* vm_new_alloc(void) __attribute__((warn_unused_result));
+
+void vm_free(VirtualMachine* pVm);
+
+// Native number `index` in the order every VM defines them, NULL past the
+// last one. Snapshots refer to natives by it.
+NativeFn vm_native(size_t const index);
+
+// Limits every run that follows, by vm_interpret*() or vm_resume(), to
+// `max_calls` calls and `max_nanoseconds` of wall time. 0 means no limit.
+// Going round a loop once counts as a call. A program that runs out is
+// suspended before the call or the loop, the run returns INTERPRET_SUSPENDED.
+void vm_set_budget(VirtualMachine* pVm, uint64_t max_calls,
+                   uint64_t max_nanoseconds);
+
+// Runs the suspended program on from where it stopped, with a new budget.
+InterpretResult vm_resume(VirtualMachine* pVm);
+
+// Drops the suspended program.
+void vm_cancel(VirtualMachine* pVm);
+
+// A suspended program has to be resumed or cancelled before the VM runs
+// another one.
+InterpretResult vm_interpret(VirtualMachine* pVm, char const* const source);
+
+// Compiles the program while it's read from `input`, buffering only a chunk
+// of it at a time.
+InterpretResult vm_interpret_stream(VirtualMachine* pVm, FILE* input);
+
+// Like vm_interpret(), but the `length` characters of `source` are scanned
+// on a thread per processor, which pays off for huge sources.
+InterpretResult vm_interpret_parallel(VirtualMachine* pVm,
+                                      char const* source, size_t length);
+
+// Like vm_interpret(), but reuses the chunk compiled the last time the same
+// source was interpreted, as long as it's still cached.
+InterpretResult vm_interpret_cached(VirtualMachine* pVm,
+                                    char const* const source);
+
+// Evaluates the arithmetic `expression` once for each of `rows` rows, with
+// its globals bound to `columns`, into `results`. Fails with a runtime error
+// when the expression uses anything but numbers and bound globals.
+InterpretResult vm_evaluate_batch(VirtualMachine* pVm, char const* expression,
+                                  BatchColumn const* columns,
+                                  size_t const column_count, size_t const rows,
+                                  double* results);
 
 #endif // !CLOX_VM_H
@@ -0,0 +1,36 @@
+use std::collections::HashMap;
+
+/// Name of an identifier, the same for every occurrence of it. Comparing and hashing it is
+/// comparing and hashing a single integer.
+#[derive(Debug, PartialEq, Eq, Hash, Clone, Copy)]
+pub struct Symbol(u32);
+
+/// Gives each distinct identifier of a source a Symbol. Names are borrowed from the source, so
+/// interning allocates only when a table grows.
+#[derive(Default)]
+pub struct Interner<'a> {
+    symbols: HashMap<&'a str, Symbol>,
+    names: Vec<&'a str>,
+}
+
+impl<'a> Interner<'a> {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn intern(&mut self, name: &'a str) -> Symbol {
+        if let Some(&symbol) = self.symbols.get(name) {
+            return symbol;
+        }
+        let symbol = Symbol(self.names.len() as u32);
+        self.names.push(name);
+        self.symbols.insert(name, symbol);
+        symbol
+    }
+
+    /// Names are read from the lexemes of tokens, so only tests look symbols up.
+    #[cfg(test)]
+    pub fn resolve(&self, symbol: Symbol) -> &'a str {
+        self.names[symbol.0 as usize]
+    }
+}
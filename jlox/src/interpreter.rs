@@ -0,0 +1,270 @@
+use crate::{
+    syntax::{Ast, Expr, ExprId, LiteralType, Visitor},
+    token::{Token, TokenType},
+    value::Value,
+};
+
+/// Error that stops the evaluation, reported with the line of the operator that caused it.
+#[derive(Debug)]
+pub struct RuntimeError {
+    line: usize,
+    message: &'static str,
+}
+
+impl RuntimeError {
+    pub fn report(&self) {
+        eprintln!("{}\n[line {}]", self.message, self.line);
+    }
+}
+
+/// State the compiled closures run in. Expressions have no variables yet, so there's nothing in
+/// it, but it's where they will live.
+#[derive(Default)]
+pub struct Env;
+
+/// An expression compiled into nested closures. Which operation every node does is decided once
+/// when compiling, so running it only calls from one closure into the next.
+pub type Compiled = Box<dyn Fn(&mut Env) -> Result<Value, RuntimeError>>;
+
+/// Compiles the root expression of `ast`. The result doesn't borrow the Ast or the source.
+pub fn compile(ast: &Ast) -> Compiled {
+    compile_expr(ast, ast.root())
+}
+
+fn compile_expr(ast: &Ast, id: ExprId) -> Compiled {
+    match *ast.expr(id) {
+        // Only strings need a clone, which bumps a reference count.
+        Expr::Literal {
+            value: LiteralType::Number(n),
+        } => Box::new(move |_| Ok(Value::Number(n))),
+        Expr::Literal { ref value } => {
+            let value = literal(value);
+            Box::new(move |_| Ok(value.clone()))
+        }
+        // A grouping only matters to the parser.
+        Expr::Grouping { expression } => compile_expr(ast, expression),
+        Expr::Unary { operator, right } => {
+            let right = compile_expr(ast, right);
+            let token = ast.token(operator);
+            let line = token.line;
+            match token.token_type {
+                TokenType::Minus => Box::new(move |env| negate(line, right(env)?)),
+                TokenType::Bang => {
+                    Box::new(move |env| Ok(Value::Boolean(!right(env)?.is_truthy())))
+                }
+                _ => unreachable!("Unary operator '{}'.", token.lexeme),
+            }
+        }
+        Expr::Binary {
+            left,
+            operator,
+            right,
+        } => {
+            let left = compile_expr(ast, left);
+            let right = compile_expr(ast, right);
+            let token = ast.token(operator);
+            let line = token.line;
+            match token.token_type {
+                TokenType::Plus => Box::new(move |env| add(line, left(env)?, right(env)?)),
+                TokenType::Minus => numeric(left, right, line, |a, b| Value::Number(a - b)),
+                TokenType::Star => numeric(left, right, line, |a, b| Value::Number(a * b)),
+                TokenType::Slash => numeric(left, right, line, |a, b| Value::Number(a / b)),
+                TokenType::Greater => numeric(left, right, line, |a, b| Value::Boolean(a > b)),
+                TokenType::GreaterEqual => {
+                    numeric(left, right, line, |a, b| Value::Boolean(a >= b))
+                }
+                TokenType::Less => numeric(left, right, line, |a, b| Value::Boolean(a < b)),
+                TokenType::LessEqual => numeric(left, right, line, |a, b| Value::Boolean(a <= b)),
+                TokenType::EqualEqual => {
+                    Box::new(move |env| Ok(Value::Boolean(left(env)? == right(env)?)))
+                }
+                TokenType::BangEqual => {
+                    Box::new(move |env| Ok(Value::Boolean(left(env)? != right(env)?)))
+                }
+                _ => unreachable!("Binary operator '{}'.", token.lexeme),
+            }
+        }
+    }
+}
+
+/// Closure of an operator that takes two numbers. `op` is a type parameter so that it's inlined
+/// into the closure instead of being called through a pointer.
+fn numeric<F>(left: Compiled, right: Compiled, line: usize, op: F) -> Compiled
+where
+    F: Fn(f64, f64) -> Value + 'static,
+{
+    Box::new(move |env| {
+        let (a, b) = numbers(line, left(env)?, right(env)?)?;
+        Ok(op(a, b))
+    })
+}
+
+/// Evaluates expressions by visiting the Ast, which matches on every node each time it's run.
+/// It's the reference for the compiled closures.
+pub struct Interpreter;
+
+impl Visitor<Result<Value, RuntimeError>> for Interpreter {
+    fn visit_binary_expr(
+        &self,
+        ast: &Ast,
+        left: ExprId,
+        operator: &Token,
+        right: ExprId,
+    ) -> Result<Value, RuntimeError> {
+        let left = ast.accept(left, self)?;
+        let right = ast.accept(right, self)?;
+        let line = operator.line;
+        match operator.token_type {
+            TokenType::Plus => add(line, left, right),
+            TokenType::Minus => numbers(line, left, right).map(|(a, b)| Value::Number(a - b)),
+            TokenType::Star => numbers(line, left, right).map(|(a, b)| Value::Number(a * b)),
+            TokenType::Slash => numbers(line, left, right).map(|(a, b)| Value::Number(a / b)),
+            TokenType::Greater => numbers(line, left, right).map(|(a, b)| Value::Boolean(a > b)),
+            TokenType::GreaterEqual => {
+                numbers(line, left, right).map(|(a, b)| Value::Boolean(a >= b))
+            }
+            TokenType::Less => numbers(line, left, right).map(|(a, b)| Value::Boolean(a < b)),
+            TokenType::LessEqual => numbers(line, left, right).map(|(a, b)| Value::Boolean(a <= b)),
+            TokenType::EqualEqual => Ok(Value::Boolean(left == right)),
+            TokenType::BangEqual => Ok(Value::Boolean(left != right)),
+            _ => unreachable!("Binary operator '{}'.", operator.lexeme),
+        }
+    }
+
+    fn visit_grouping_expr(&self, ast: &Ast, expression: ExprId) -> Result<Value, RuntimeError> {
+        ast.accept(expression, self)
+    }
+
+    fn visit_literal_expr(&self, value: &LiteralType) -> Result<Value, RuntimeError> {
+        Ok(literal(value))
+    }
+
+    fn visit_unary_expr(
+        &self,
+        ast: &Ast,
+        operator: &Token,
+        right: ExprId,
+    ) -> Result<Value, RuntimeError> {
+        let right = ast.accept(right, self)?;
+        match operator.token_type {
+            TokenType::Minus => negate(operator.line, right),
+            TokenType::Bang => Ok(Value::Boolean(!right.is_truthy())),
+            _ => unreachable!("Unary operator '{}'.", operator.lexeme),
+        }
+    }
+}
+
+// Semantics of the operators, shared by both evaluators.
+
+fn literal(value: &LiteralType) -> Value {
+    match *value {
+        LiteralType::Number(n) => Value::Number(n),
+        LiteralType::String(s) => Value::String(s.into()),
+        LiteralType::Boolean(b) => Value::Boolean(b),
+        LiteralType::Nil => Value::Nil,
+    }
+}
+
+fn negate(line: usize, right: Value) -> Result<Value, RuntimeError> {
+    match right {
+        Value::Number(n) => Ok(Value::Number(-n)),
+        _ => Err(RuntimeError {
+            line,
+            message: "Operand must be a number.",
+        }),
+    }
+}
+
+fn add(line: usize, left: Value, right: Value) -> Result<Value, RuntimeError> {
+    match (left, right) {
+        (Value::Number(a), Value::Number(b)) => Ok(Value::Number(a + b)),
+        (Value::String(a), Value::String(b)) => Ok(Value::String([&*a, &*b].concat().into())),
+        _ => Err(RuntimeError {
+            line,
+            message: "Operands must be two numbers or two strings.",
+        }),
+    }
+}
+
+fn numbers(line: usize, left: Value, right: Value) -> Result<(f64, f64), RuntimeError> {
+    match (left, right) {
+        (Value::Number(a), Value::Number(b)) => Ok((a, b)),
+        _ => Err(RuntimeError {
+            line,
+            message: "Operands must be numbers.",
+        }),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::interner::Interner;
+    use crate::parser::parse;
+    use crate::scanner;
+    use std::time::Instant;
+
+    fn parse_source<'a>(source: &'a str, interner: &mut Interner<'a>) -> Ast<'a> {
+        let (tokens, had_error) = scanner::scan_tokens(source, interner);
+        assert_eq!(had_error, false, "Failed to scan the test code.");
+        parse(tokens).expect("Failed to parse the test code.")
+    }
+
+    #[test]
+    fn test_evaluators_agree() {
+        let cases = [
+            ("(1 + 2) * 3 - 4 / 8", "8.5"),
+            ("\"ab\" + \"cd\" == \"abcd\"", "true"),
+            ("!(1 < 2) != !nil", "true"),
+            ("-(3 >= 3 == true)", "Operand must be a number."),
+            ("1 + \"a\"", "Operands must be two numbers or two strings."),
+        ];
+        for (source, expected) in cases {
+            let mut interner = Interner::new();
+            let ast = parse_source(source, &mut interner);
+            let show = |result: Result<Value, RuntimeError>| match result {
+                Ok(value) => value.to_string(),
+                Err(e) => e.message.to_string(),
+            };
+            assert_eq!(show(ast.accept(ast.root(), &Interpreter)), expected);
+            assert_eq!(show(compile(&ast)(&mut Env)), expected);
+        }
+    }
+
+    #[test]
+    fn test_benchmark() {
+        let term = "(-(1 + 2) * 3 - 4 / (5 + 6) * (7 - 8))";
+        let source = vec![term; 1000].join(" + ");
+        let mut interner = Interner::new();
+        let ast = parse_source(&source, &mut interner);
+        let runs = 200;
+
+        let begin = Instant::now();
+        let mut visited = Value::Nil;
+        for _ in 0..runs {
+            visited = ast.accept(ast.root(), &Interpreter).unwrap();
+        }
+        let visitor_time = begin.elapsed();
+
+        let begin = Instant::now();
+        let compiled = compile(&ast);
+        let compile_time = begin.elapsed();
+        let begin = Instant::now();
+        let mut env = Env;
+        let mut result = Value::Nil;
+        for _ in 0..runs {
+            result = compiled(&mut env).unwrap();
+        }
+        let closure_time = begin.elapsed();
+
+        assert_eq!(result, visited);
+        println!(
+            "{} runs: visitor {:?}, closures {:?} (+{:?} compiling), {:.2}x",
+            runs,
+            visitor_time,
+            closure_time,
+            compile_time,
+            visitor_time.as_secs_f64() / closure_time.as_secs_f64()
+        );
+    }
+}
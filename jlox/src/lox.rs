@@ -1,4 +1,10 @@
-use crate::{parser::parse, scanner, syntax::AstPrinter};
+use crate::{
+    interner::Interner,
+    interpreter::{self, Env, Interpreter},
+    parser::parse,
+    scanner,
+    syntax::AstPrinter,
+};
 use std::{
     fs,
     io::{self, Write},
@@ -11,17 +17,29 @@ pub enum LoxError {
     IoError(std::io::Error),
     Scanning,
     Parsing,
+    Runtime,
+}
+
+/// What is done with a parsed expression.
+#[derive(Clone, Copy)]
+pub enum Engine {
+    /// Compiles it into closures and runs those.
+    Closures,
+    /// Evaluates it by visiting the AST, to cross-check the closures.
+    Visitor,
+    /// Prints the AST instead of running it.
+    PrintAst,
 }
 
 /// Reads the file and executes it.
-pub fn run_file(path: &Path) -> Result<(), LoxError> {
+pub fn run_file(path: &Path, engine: Engine) -> Result<(), LoxError> {
     let content = fs::read_to_string(path)?;
-    run(&content)?;
+    run(&content, engine)?;
     Ok(())
 }
 
 /// Starts an interactive prompt where it's possible to execute one line at a time.
-pub fn run_prompt() -> Result<(), LoxError> {
+pub fn run_prompt(engine: Engine) -> Result<(), LoxError> {
     loop {
         print!("> ");
         io::stdout().flush()?;
@@ -34,22 +52,37 @@ pub fn run_prompt() -> Result<(), LoxError> {
             break;
         }
         // The REPL should not terminate after encountering an error, so we are ignoring it
-        let _ = run(&buf);
+        let _ = run(&buf, engine);
     }
     Ok(())
 }
 
-fn run(source: &str) -> Result<(), LoxError> {
-    let (tokens, had_error) = scanner::scan_tokens(source);
-    if !had_error {
-        let expr = match parse(tokens) {
-            Some(val) => val,
-            None => return Err(LoxError::Parsing),
-        };
-        let printer = AstPrinter;
-        println!("{}", expr.accept(&printer));
+fn run(source: &str, engine: Engine) -> Result<(), LoxError> {
+    let mut interner = Interner::new();
+    let (tokens, had_error) = scanner::scan_tokens(source, &mut interner);
+    if had_error {
+        return Err(LoxError::Scanning);
     }
-    Err(LoxError::Scanning)
+    let ast = match parse(tokens) {
+        Some(val) => val,
+        None => return Err(LoxError::Parsing),
+    };
+    let result = match engine {
+        Engine::Closures => interpreter::compile(&ast)(&mut Env),
+        Engine::Visitor => ast.accept(ast.root(), &Interpreter),
+        Engine::PrintAst => {
+            println!("{}", ast.accept(ast.root(), &AstPrinter));
+            return Ok(());
+        }
+    };
+    match result {
+        Ok(value) => println!("{}", value),
+        Err(e) => {
+            e.report();
+            return Err(LoxError::Runtime);
+        }
+    }
+    Ok(())
 }
 
 impl std::fmt::Display for LoxError {
@@ -58,6 +91,7 @@ impl std::fmt::Display for LoxError {
             Self::IoError(e) => e.fmt(f),
             Self::Scanning => write!(f, "Could not execute due to an error while scanning."),
             Self::Parsing => write!(f, "Could not execute due to an error while parsing."),
+            Self::Runtime => write!(f, "Could not execute due to an error while running."),
         }
     }
 }
@@ -1,8 +1,11 @@
+mod interner;
+mod interpreter;
 mod lox;
 mod parser;
 mod scanner;
 mod syntax;
 mod token;
+mod value;
 
 use std::cmp;
 use std::env;
@@ -11,20 +14,32 @@ use std::process;
 
 fn main() -> Result<(), lox::LoxError> {
     // Lox can start in an interactive mode if there is no argument, or parse a file specified in
-    // the first argument
-    let args: Vec<String> = env::args().collect();
+    // the first argument. An option before it picks another engine than the compiled closures.
+    let mut args: Vec<String> = env::args().collect();
+    let engine = match args.get(1).map(String::as_str) {
+        Some("--visitor") => Some(lox::Engine::Visitor),
+        Some("--print-ast") => Some(lox::Engine::PrintAst),
+        _ => None,
+    };
+    let engine = match engine {
+        Some(engine) => {
+            args.remove(1);
+            engine
+        }
+        None => lox::Engine::Closures,
+    };
     // 2 because the first argument is the program's name
     match args.len().cmp(&2) {
         cmp::Ordering::Greater => {
             // Exit with code EX_USAGE (64) if there is more than one argument
-            println!("Usage: {} [script]", args[0]);
+            println!("Usage: {} [--visitor | --print-ast] [script]", args[0]);
             process::exit(64);
         }
         cmp::Ordering::Equal => {
             let path = Path::new(&args[1]);
-            lox::run_file(path)?;
+            lox::run_file(path, engine)?;
         }
-        cmp::Ordering::Less => lox::run_prompt()?,
+        cmp::Ordering::Less => lox::run_prompt(engine)?,
     }
     Ok(())
 }
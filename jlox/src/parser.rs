@@ -1,5 +1,5 @@
 use crate::{
-    syntax::{Expr, LiteralType},
+    syntax::{Ast, Expr, ExprId, LiteralType},
     token::{Token, TokenType},
 };
 
@@ -11,23 +11,27 @@ use crate::{
 /// factor     -> unary ( ( "/" | "*" ) unary )* ;
 /// unary      -> ( "!" | "-" ) unary | primary ;
 /// primary    -> NUMBER | STRING | "true" | "false" | "nil" | "(" expression ")" ;
-struct Parser {
-    tokens: Vec<Token>,
+struct Parser<'a> {
+    ast: Ast<'a>,
     current: usize,
 }
 
 /// Error that will be reported when the Parser encounters something wrong.
-struct ParserError {
-    token: Token,
+struct ParserError<'a> {
+    token: Token<'a>,
     message: &'static str,
 }
 
-/// Parses the given tokens and returns the resultant expression in the Some variant. If an error
-/// occurred while parsing, the error will be reported and None will be returned.
-pub fn parse(tokens: Vec<Token>) -> Option<Expr> {
-    let mut parser = Parser { tokens, current: 0 };
+/// Parses the given tokens and returns the resultant Ast, whose root is the expression, in the Some
+/// variant. If an error occurred while parsing, the error will be reported and None will be
+/// returned.
+pub fn parse(tokens: Vec<Token>) -> Option<Ast> {
+    let mut parser = Parser {
+        ast: Ast::new(tokens),
+        current: 0,
+    };
     match parser.expression() {
-        Ok(expr) => Some(expr),
+        Ok(_) => Some(parser.ast),
         Err(e) => {
             e.report();
             None
@@ -50,26 +54,26 @@ macro_rules! matches {
     };
 }
 
-impl Parser {
-    fn expression(&mut self) -> Result<Expr, ParserError> {
+impl<'a> Parser<'a> {
+    fn expression(&mut self) -> Result<ExprId, ParserError<'a>> {
         self.equality()
     }
 
-    fn equality(&mut self) -> Result<Expr, ParserError> {
+    fn equality(&mut self) -> Result<ExprId, ParserError<'a>> {
         let mut expr = self.comparison()?;
         while matches!(self, TokenType::BangEqual, TokenType::EqualEqual) {
-            let operator: Token = (*self.previous()).clone();
-            let right: Expr = self.comparison()?;
-            expr = Expr::Binary {
-                left: Box::new(expr),
+            let operator = self.ast.token_id(self.current - 1);
+            let right = self.comparison()?;
+            expr = self.ast.add(Expr::Binary {
+                left: expr,
                 operator,
-                right: Box::new(right),
-            };
+                right,
+            });
         }
         Ok(expr)
     }
 
-    fn comparison(&mut self) -> Result<Expr, ParserError> {
+    fn comparison(&mut self) -> Result<ExprId, ParserError<'a>> {
         let mut expr = self.addition()?;
         while matches!(
             self,
@@ -78,60 +82,58 @@ impl Parser {
             TokenType::Less,
             TokenType::LessEqual
         ) {
-            let operator: Token = self.previous().clone();
+            let operator = self.ast.token_id(self.current - 1);
             let right = self.addition()?;
-            expr = Expr::Binary {
-                left: Box::new(expr),
+            expr = self.ast.add(Expr::Binary {
+                left: expr,
                 operator,
-                right: Box::new(right),
-            }
+                right,
+            })
         }
         Ok(expr)
     }
 
-    fn addition(&mut self) -> Result<Expr, ParserError> {
+    fn addition(&mut self) -> Result<ExprId, ParserError<'a>> {
         let mut expr = self.multiplication()?;
         while matches!(self, TokenType::Minus, TokenType::Plus) {
-            let operator: Token = self.previous().clone();
+            let operator = self.ast.token_id(self.current - 1);
             let right = self.multiplication()?;
-            expr = Expr::Binary {
-                left: Box::new(expr),
+            expr = self.ast.add(Expr::Binary {
+                left: expr,
                 operator,
-                right: Box::new(right),
-            }
+                right,
+            })
         }
         Ok(expr)
     }
 
-    fn multiplication(&mut self) -> Result<Expr, ParserError> {
+    fn multiplication(&mut self) -> Result<ExprId, ParserError<'a>> {
         let mut expr = self.unary()?;
         while matches!(self, TokenType::Slash, TokenType::Star) {
-            let operator: Token = self.previous().clone();
+            let operator = self.ast.token_id(self.current - 1);
             let right = self.unary()?;
-            expr = Expr::Binary {
-                left: Box::new(expr),
+            expr = self.ast.add(Expr::Binary {
+                left: expr,
                 operator,
-                right: Box::new(right),
-            }
+                right,
+            })
         }
         Ok(expr)
     }
 
-    fn unary(&mut self) -> Result<Expr, ParserError> {
+    fn unary(&mut self) -> Result<ExprId, ParserError<'a>> {
         if matches!(self, TokenType::Bang, TokenType::Minus) {
-            let operator = self.previous().clone();
+            let operator = self.ast.token_id(self.current - 1);
             let right = self.unary()?;
-            Ok(Expr::Unary {
-                operator,
-                right: Box::new(right),
-            })
+            Ok(self.ast.add(Expr::Unary { operator, right }))
         } else {
             self.primary()
         }
     }
 
-    fn primary(&mut self) -> Result<Expr, ParserError> {
-        let expr = match &self.peek().token_type {
+    fn primary(&mut self) -> Result<ExprId, ParserError<'a>> {
+        let token = *self.peek();
+        let expr = match token.token_type {
             TokenType::False => Expr::Literal {
                 value: LiteralType::Boolean(false),
             },
@@ -141,29 +143,28 @@ impl Parser {
             TokenType::Nil => Expr::Literal {
                 value: LiteralType::Nil,
             },
-            TokenType::String(s) => Expr::Literal {
-                value: LiteralType::String(s.to_string()),
+            TokenType::String => Expr::Literal {
+                value: LiteralType::String(token.string_value()),
             },
-            TokenType::Number(n) => Expr::Literal {
-                value: LiteralType::Number(*n),
+            TokenType::Number => Expr::Literal {
+                value: LiteralType::Number(token.number_value()),
             },
             TokenType::LeftParen => {
                 self.advance(); // so it doesn't keep finding the same LeftParen
                 let expr = self.expression()?;
                 self.consume(TokenType::RightParen, "Expected ')' after expression.")?;
-                Expr::Grouping {
-                    expression: Box::new(expr),
-                }
+                // consume() already advanced past the ')'
+                return Ok(self.ast.add(Expr::Grouping { expression: expr }));
             }
             _ => {
                 return Err(ParserError {
-                    token: self.peek().clone(),
+                    token,
                     message: "Expected expression.",
                 })
             }
         };
         self.advance();
-        Ok(expr)
+        Ok(self.ast.add(expr))
     }
 
     fn synchronize(&mut self) {
@@ -190,25 +191,27 @@ impl Parser {
         &mut self,
         token_type: TokenType,
         message: &'static str,
-    ) -> Result<&Token, ParserError> {
+    ) -> Result<&Token<'a>, ParserError<'a>> {
         if self.check(token_type) {
             Ok(self.advance())
         } else {
             Err(ParserError {
-                token: self.peek().clone(),
+                token: *self.peek(),
                 message,
             })
         }
     }
 
-    fn peek(&self) -> &Token {
-        self.tokens
+    fn peek(&self) -> &Token<'a> {
+        self.ast
+            .tokens()
             .get(self.current)
             .expect("Peek into end of token stream.")
     }
 
-    fn previous(&self) -> &Token {
-        self.tokens
+    fn previous(&self) -> &Token<'a> {
+        self.ast
+            .tokens()
             .get(self.current - 1)
             .expect("Previous token was empty.")
     }
@@ -217,7 +220,7 @@ impl Parser {
         self.peek().token_type == TokenType::Eof
     }
 
-    fn advance(&mut self) -> &Token {
+    fn advance(&mut self) -> &Token<'a> {
         if !self.is_at_end() {
             self.current += 1;
         }
@@ -232,7 +235,7 @@ impl Parser {
     }
 }
 
-impl ParserError {
+impl ParserError<'_> {
     fn report(&self) {
         match self.token.token_type {
             TokenType::Eof => {
@@ -240,9 +243,7 @@ impl ParserError {
             }
             _ => eprintln!(
                 "[line {}] Error at '{}': {}",
-                self.token.line,
-                self.token.lexeme(),
-                self.message
+                self.token.line, self.token.lexeme, self.message
             ),
         }
     }
@@ -251,15 +252,17 @@ impl ParserError {
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::interner::Interner;
     use crate::scanner;
     use crate::syntax::AstPrinter;
 
     #[test]
     fn test_parser() {
-        let (tokens, had_error) = scanner::scan_tokens("-123 * 45.67");
+        let mut interner = Interner::new();
+        let (tokens, had_error) = scanner::scan_tokens("-123 * 45.67", &mut interner);
         assert_eq!(had_error, false, "Failed to scan the test code.");
-        let expression = parse(tokens).expect("Failed to parse the test code.");
+        let ast = parse(tokens).expect("Failed to parse the test code.");
         let printer = AstPrinter;
-        assert_eq!(expression.accept(&printer), "(* (- 123) 45.67)");
+        assert_eq!(ast.accept(ast.root(), &printer), "(* (- 123) 45.67)");
     }
 }
@@ -1,4 +1,7 @@
-use crate::token::{Token, TokenType};
+use crate::{
+    interner::Interner,
+    token::{Token, TokenType},
+};
 
 /// Errors that can happen in the scanning process. The usize variable is to annotate the line
 /// number.
@@ -10,9 +13,12 @@ enum ScannerError {
 /// Struct responsible for scanning the source code and generating tokens.
 /// This object should not be instantiated and its only reason is for grouping all the data and helper
 /// functions in scan_tokens()
-pub struct Scanner<'a> {
+pub struct Scanner<'a, 'i> {
     source: &'a str,
-    tokens: Vec<Token>,
+    tokens: Vec<Token<'a>>,
+    interner: &'i mut Interner<'a>,
+    // `start` and `current` are byte offsets into `source`, always on a char boundary, so a
+    // character is read in constant time and lexemes are sliced directly.
     start: usize,
     current: usize,
     line: usize,
@@ -20,9 +26,10 @@ pub struct Scanner<'a> {
 
 /// Scans the source code and returns a vector with the tokens and a bool indicating if an error occurred.
 /// The scanner doesn't stop parsing the tokens if there was an error due to the book's implementation.
-pub fn scan_tokens(source: &str) -> (Vec<Token>, bool) {
+/// Tokens borrow their lexemes from the source, and identifiers are interned into `interner`.
+pub fn scan_tokens<'a>(source: &'a str, interner: &mut Interner<'a>) -> (Vec<Token<'a>>, bool) {
     let mut had_error = false;
-    let mut scanner = Scanner::new(source);
+    let mut scanner = Scanner::new(source, interner);
     while !scanner.is_at_end() {
         scanner.start = scanner.current;
         if let Err(e) = scanner.scan_token() {
@@ -39,17 +46,19 @@ pub fn scan_tokens(source: &str) -> (Vec<Token>, bool) {
     }
     scanner.tokens.push(Token {
         token_type: TokenType::Eof,
+        lexeme: "",
         line: scanner.line,
     });
     (scanner.tokens, had_error)
 }
 
 // There's only one public function, scan_tokens(), the rest are helpers.
-impl<'a> Scanner<'a> {
-    fn new(source: &'a str) -> Self {
+impl<'a, 'i> Scanner<'a, 'i> {
+    fn new(source: &'a str, interner: &'i mut Interner<'a>) -> Self {
         Self {
             source,
             tokens: Vec::new(),
+            interner,
             start: 0,
             current: 0,
             line: 1,
@@ -132,17 +141,23 @@ impl<'a> Scanner<'a> {
     }
 
     fn peek(&self) -> char {
-        // We can call unwrap here since we won't encounter a EOF
-        self.source.chars().nth(self.current).unwrap_or('\0')
+        // Every character Lox gives a meaning to is ASCII, so the common case is a single byte
+        match self.source.as_bytes().get(self.current) {
+            Some(&b) if b.is_ascii() => b as char,
+            Some(_) => self.source[self.current..].chars().next().unwrap_or('\0'),
+            None => '\0',
+        }
     }
 
     fn peek_next(&self) -> char {
-        self.source.chars().nth(self.current + 1).unwrap_or('\0')
+        let mut chars = self.source[self.current..].chars();
+        chars.next();
+        chars.next().unwrap_or('\0')
     }
 
     fn advance(&mut self) -> char {
         let c = self.peek();
-        self.current += 1;
+        self.current += c.len_utf8();
         c
     }
 
@@ -150,13 +165,18 @@ impl<'a> Scanner<'a> {
         if self.is_at_end() || self.peek() != expected {
             return false;
         }
-        self.current += 1;
+        self.current += expected.len_utf8();
         true
     }
 
+    fn lexeme(&self) -> &'a str {
+        &self.source[self.start..self.current]
+    }
+
     fn add_token(&mut self, token_type: TokenType) {
         self.tokens.push(Token {
             token_type,
+            lexeme: self.lexeme(),
             line: self.line,
         });
     }
@@ -173,12 +193,7 @@ impl<'a> Scanner<'a> {
         }
         // Advances for the closing '"'
         self.advance();
-        // Trim the surrouding quotes
-        let value = &self.source[self.start + 1..self.current - 1];
-        self.tokens.push(Token {
-            token_type: TokenType::String(value.to_string()),
-            line: self.line,
-        });
+        self.add_token(TokenType::String);
         Ok(())
     }
 
@@ -193,18 +208,14 @@ impl<'a> Scanner<'a> {
                 self.advance();
             }
         }
-        self.add_token(TokenType::Number(
-            self.source[self.start..self.current]
-                .parse::<f64>()
-                .unwrap(),
-        ))
+        self.add_token(TokenType::Number)
     }
 
     fn identifier(&mut self) {
         while self.peek().is_alphanumeric() {
             self.advance();
         }
-        let text = &self.source[self.start..self.current];
+        let text = self.lexeme();
         let token_type = match text {
             "and" => TokenType::And,
             "class" => TokenType::Class,
@@ -222,8 +233,61 @@ impl<'a> Scanner<'a> {
             "true" => TokenType::True,
             "var" => TokenType::Var,
             "while" => TokenType::While,
-            _ => TokenType::Identifier(text.to_string()),
+            _ => TokenType::Identifier(self.interner.intern(text)),
         };
         self.add_token(token_type);
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::time::Instant;
+
+    #[test]
+    fn test_non_ascii() {
+        let mut interner = Interner::new();
+        let (tokens, had_error) = scan_tokens("var ñandú = \"día\nnoche\"; ñandú;", &mut interner);
+        assert_eq!(had_error, false, "Failed to scan the test code.");
+        let name = interner.intern("ñandú");
+        let types: Vec<TokenType> = tokens.iter().map(|t| t.token_type).collect();
+        assert_eq!(
+            types,
+            vec![
+                TokenType::Var,
+                TokenType::Identifier(name),
+                TokenType::Equal,
+                TokenType::String,
+                TokenType::Semicolon,
+                TokenType::Identifier(name),
+                TokenType::Semicolon,
+                TokenType::Eof,
+            ]
+        );
+        assert_eq!(tokens[1].lexeme, "ñandú");
+        assert_eq!(tokens[3].string_value(), "día\nnoche");
+        assert_eq!(interner.resolve(name), "ñandú");
+    }
+
+    #[test]
+    fn test_throughput() {
+        // About 4 MB, which took minutes while every peek walked the source from its start.
+        let line = "var résumé = (12.5 + count) * 3; // コメント\nprint \"ünïcödé\" != nil;\n";
+        let repeat = 4 * 1024 * 1024 / line.len();
+        let source = line.repeat(repeat);
+        let begin = Instant::now();
+        let mut interner = Interner::new();
+        let (tokens, had_error) = scan_tokens(&source, &mut interner);
+        let elapsed = begin.elapsed();
+        assert_eq!(had_error, false, "Failed to scan the test code.");
+        assert_eq!(tokens.len(), 16 * repeat + 1);
+        assert_eq!(tokens.last().unwrap().line, 2 * repeat + 1);
+        let megabytes = source.len() as f64 / (1024.0 * 1024.0);
+        println!(
+            "scanned {:.1} MB in {:?} ({:.1} MB/s)",
+            megabytes,
+            elapsed,
+            megabytes / elapsed.as_secs_f64()
+        );
+    }
+}
@@ -1,73 +1,124 @@
 use crate::token::Token;
 
+/// Index of an expression in its Ast.
+#[derive(Debug, PartialEq, Clone, Copy)]
+pub struct ExprId(u32);
+
+/// Index of a token in its Ast.
+#[derive(Debug, PartialEq, Clone, Copy)]
+pub struct TokenId(u32);
+
 /// Lox's expression grammar.
-/// The Expr needs to be boxed in certain values because Expr is an enum that references itself,
-/// and this can be recursive, so the size is not known at compile time.
-pub enum Expr {
+/// Expressions live in an Ast and refer to their operands and tokens by index, so a tree is two
+/// flat vectors instead of a heap allocation per node.
+pub enum Expr<'a> {
     Literal {
-        value: LiteralType,
+        value: LiteralType<'a>,
     },
     Grouping {
-        expression: Box<Expr>,
+        expression: ExprId,
     },
     Unary {
-        operator: Token,
-        right: Box<Expr>,
+        operator: TokenId,
+        right: ExprId,
     },
     Binary {
-        left: Box<Expr>,
-        operator: Token,
-        right: Box<Expr>,
+        left: ExprId,
+        operator: TokenId,
+        right: ExprId,
     },
 }
 
 /// Type of the literal. The grammar is:
 /// literal -> NUMBER | STRING | "true" | "false" | "nil";
-pub enum LiteralType {
+pub enum LiteralType<'a> {
     Number(f64),
-    String(String),
+    String(&'a str),
     Boolean(bool),
     Nil,
 }
 
-/// Visitor pattern that will be implemented by each expression.
-/// The rationale behind this is that, by using the accept() function on Expr, we already have a
-/// match of what visitor function we will run, so we can implement these functions to change its
-/// return type.
-pub trait Visitor<R> {
-    fn visit_binary_expr(&self, left: &Expr, operator: &Token, right: &Expr) -> R;
-    fn visit_grouping_expr(&self, expression: &Expr) -> R;
-    fn visit_literal_expr(&self, value: &LiteralType) -> R;
-    fn visit_unary_expr(&self, operator: &Token, right: &Expr) -> R;
+/// Arena of the expressions parsed from a list of tokens. Operands are added before the
+/// expression that uses them, so the root is the last one.
+pub struct Ast<'a> {
+    tokens: Vec<Token<'a>>,
+    exprs: Vec<Expr<'a>>,
 }
 
-impl Expr {
+impl<'a> Ast<'a> {
+    pub fn new(tokens: Vec<Token<'a>>) -> Self {
+        Self {
+            tokens,
+            exprs: Vec::new(),
+        }
+    }
+
+    pub fn add(&mut self, expr: Expr<'a>) -> ExprId {
+        self.exprs.push(expr);
+        ExprId(self.exprs.len() as u32 - 1)
+    }
+
+    pub fn root(&self) -> ExprId {
+        assert!(!self.exprs.is_empty(), "The Ast is empty.");
+        ExprId(self.exprs.len() as u32 - 1)
+    }
+
+    pub fn expr(&self, id: ExprId) -> &Expr<'a> {
+        &self.exprs[id.0 as usize]
+    }
+
+    pub fn token_id(&self, index: usize) -> TokenId {
+        debug_assert!(index < self.tokens.len());
+        TokenId(index as u32)
+    }
+
+    pub fn token(&self, id: TokenId) -> &Token<'a> {
+        &self.tokens[id.0 as usize]
+    }
+
+    pub fn tokens(&self) -> &[Token<'a>] {
+        &self.tokens
+    }
+
     /// Function to run in each expression. See the Visitor design pattern for more details.
-    pub fn accept<R>(&self, visitor: &dyn Visitor<R>) -> R {
-        match self {
-            Expr::Literal { value } => visitor.visit_literal_expr(value),
-            Expr::Grouping { expression } => visitor.visit_grouping_expr(expression),
-            Expr::Unary { operator, right } => visitor.visit_unary_expr(operator, right),
+    pub fn accept<R>(&self, id: ExprId, visitor: &dyn Visitor<R>) -> R {
+        match *self.expr(id) {
+            Expr::Literal { ref value } => visitor.visit_literal_expr(value),
+            Expr::Grouping { expression } => visitor.visit_grouping_expr(self, expression),
+            Expr::Unary { operator, right } => {
+                visitor.visit_unary_expr(self, self.token(operator), right)
+            }
             Expr::Binary {
                 left,
                 operator,
                 right,
-            } => visitor.visit_binary_expr(left, operator, right),
+            } => visitor.visit_binary_expr(self, left, self.token(operator), right),
         }
     }
 }
 
+/// Visitor pattern that will be implemented by each expression.
+/// The rationale behind this is that, by using the accept() function on Ast, we already have a
+/// match of what visitor function we will run, so we can implement these functions to change its
+/// return type. Operands are visited by passing them to `ast.accept()`.
+pub trait Visitor<R> {
+    fn visit_binary_expr(&self, ast: &Ast, left: ExprId, operator: &Token, right: ExprId) -> R;
+    fn visit_grouping_expr(&self, ast: &Ast, expression: ExprId) -> R;
+    fn visit_literal_expr(&self, value: &LiteralType) -> R;
+    fn visit_unary_expr(&self, ast: &Ast, operator: &Token, right: ExprId) -> R;
+}
+
 /// Pretty prints the AST tree.
 pub struct AstPrinter;
 
 impl AstPrinter {
-    fn parenthesize(&self, name: &str, exprs: Vec<&Expr>) -> String {
+    fn parenthesize(&self, ast: &Ast, name: &str, exprs: &[ExprId]) -> String {
         let mut s = String::new();
         s.push('(');
         s.push_str(name);
-        for expr in exprs {
+        for &expr in exprs {
             s.push(' ');
-            s.push_str(&expr.accept::<String>(self));
+            s.push_str(&ast.accept::<String>(expr, self));
         }
         s.push(')');
         s
@@ -75,16 +126,22 @@ impl AstPrinter {
 }
 
 impl Visitor<String> for AstPrinter {
-    fn visit_binary_expr(&self, left: &Expr, operator: &Token, right: &Expr) -> String {
-        self.parenthesize(&operator.lexeme(), vec![left, right])
+    fn visit_binary_expr(
+        &self,
+        ast: &Ast,
+        left: ExprId,
+        operator: &Token,
+        right: ExprId,
+    ) -> String {
+        self.parenthesize(ast, operator.lexeme, &[left, right])
     }
 
-    fn visit_grouping_expr(&self, expr: &Expr) -> String {
-        self.parenthesize("group", vec![expr])
+    fn visit_grouping_expr(&self, ast: &Ast, expr: ExprId) -> String {
+        self.parenthesize(ast, "group", &[expr])
     }
 
-    fn visit_unary_expr(&self, operator: &Token, right: &Expr) -> String {
-        self.parenthesize(&operator.lexeme(), vec![right])
+    fn visit_unary_expr(&self, ast: &Ast, operator: &Token, right: ExprId) -> String {
+        self.parenthesize(ast, operator.lexeme, &[right])
     }
 
     fn visit_literal_expr(&self, value: &LiteralType) -> String {
@@ -112,27 +169,32 @@ mod tests {
 
     #[test]
     fn test_printer() {
-        let expression = Expr::Binary {
-            left: Box::new(Expr::Unary {
-                operator: Token {
-                    token_type: TokenType::Minus,
-                    line: 1,
-                },
-                right: Box::new(Expr::Literal {
-                    value: LiteralType::Number(123.0),
-                }),
-            }),
-            operator: Token {
-                token_type: TokenType::Star,
-                line: 1,
-            },
-            right: Box::new(Expr::Grouping {
-                expression: Box::new(Expr::Literal {
-                    value: LiteralType::Number(45.67),
-                }),
-            }),
+        let token = |token_type, lexeme| Token {
+            token_type,
+            lexeme,
+            line: 1,
         };
+        let mut ast = Ast::new(vec![
+            token(TokenType::Minus, "-"),
+            token(TokenType::Star, "*"),
+        ]);
+        let number = ast.add(Expr::Literal {
+            value: LiteralType::Number(123.0),
+        });
+        let left = ast.add(Expr::Unary {
+            operator: ast.token_id(0),
+            right: number,
+        });
+        let number = ast.add(Expr::Literal {
+            value: LiteralType::Number(45.67),
+        });
+        let right = ast.add(Expr::Grouping { expression: number });
+        let root = ast.add(Expr::Binary {
+            left,
+            operator: ast.token_id(1),
+            right,
+        });
         let printer = AstPrinter;
-        assert_eq!(expression.accept(&printer), "(* (- 123) (group 45.67))");
+        assert_eq!(ast.accept(root, &printer), "(* (- 123) (group 45.67))");
     }
 }
@@ -1,18 +1,31 @@
-/// Bundled lexeme with information around it.
-#[derive(Clone)]
-pub struct Token {
+use crate::interner::Symbol;
+
+/// Bundled lexeme with information around it. The lexeme is borrowed from the source, so a token
+/// is a few words that are copied around instead of cloned.
+#[derive(Clone, Copy)]
+pub struct Token<'a> {
     pub token_type: TokenType,
+    pub lexeme: &'a str,
     pub line: usize,
 }
 
-impl Token {
-    pub fn lexeme(&self) -> String {
-        format!("{}", self.token_type)
+impl<'a> Token<'a> {
+    /// Value of a String token, which is its lexeme without the quotes.
+    pub fn string_value(&self) -> &'a str {
+        &self.lexeme[1..self.lexeme.len() - 1]
+    }
+
+    /// Value of a Number token. The scanner only produces lexemes that parse.
+    pub fn number_value(&self) -> f64 {
+        self.lexeme
+            .parse()
+            .expect("Number token with an invalid lexeme.")
     }
 }
 
-/// Type of the token. All the types match a language feature.
-#[derive(Debug, PartialEq, Clone)]
+/// Type of the token. All the types match a language feature. Literal values are read from the
+/// lexeme when they're needed.
+#[derive(Debug, PartialEq, Clone, Copy)]
 pub enum TokenType {
     // Single-character tokens
     LeftParen,
@@ -36,9 +49,9 @@ pub enum TokenType {
     Less,
     LessEqual,
     // Literals
-    Identifier(String),
-    String(String),
-    Number(f64),
+    Identifier(Symbol),
+    String,
+    Number,
     // Keywords
     And,
     Class,
@@ -59,49 +72,3 @@ pub enum TokenType {
     // EOF
     Eof,
 }
-
-impl std::fmt::Display for TokenType {
-    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
-        match &self {
-            TokenType::LeftParen => f.write_str("("),
-            TokenType::RightParen => f.write_str(")"),
-            TokenType::LeftBrace => f.write_str("{"),
-            TokenType::RightBrace => f.write_str("}"),
-            TokenType::Comma => f.write_str(","),
-            TokenType::Dot => f.write_str("."),
-            TokenType::Minus => f.write_str("-"),
-            TokenType::Plus => f.write_str("+"),
-            TokenType::Semicolon => f.write_str(";"),
-            TokenType::Slash => f.write_str("/"),
-            TokenType::Star => f.write_str("*"),
-            TokenType::Bang => f.write_str("!"),
-            TokenType::BangEqual => f.write_str("!="),
-            TokenType::Equal => f.write_str("="),
-            TokenType::EqualEqual => f.write_str("=="),
-            TokenType::Greater => f.write_str(">"),
-            TokenType::GreaterEqual => f.write_str(">="),
-            TokenType::Less => f.write_str("<"),
-            TokenType::LessEqual => f.write_str("<="),
-            TokenType::Identifier(s) => f.write_str(s),
-            TokenType::String(s) => s.fmt(f),
-            TokenType::Number(n) => n.fmt(f),
-            TokenType::And => f.write_str("and"),
-            TokenType::Class => f.write_str("class"),
-            TokenType::Else => f.write_str("else"),
-            TokenType::False => f.write_str("false"),
-            TokenType::Fun => f.write_str("fun"),
-            TokenType::For => f.write_str("for"),
-            TokenType::If => f.write_str("if"),
-            TokenType::Nil => f.write_str("nil"),
-            TokenType::Or => f.write_str("or"),
-            TokenType::Print => f.write_str("print"),
-            TokenType::Return => f.write_str("return"),
-            TokenType::Super => f.write_str("super"),
-            TokenType::This => f.write_str("this"),
-            TokenType::True => f.write_str("true"),
-            TokenType::Var => f.write_str("var"),
-            TokenType::While => f.write_str("while"),
-            TokenType::Eof => f.write_str("EOF"),
-        }
-    }
-}
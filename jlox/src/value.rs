@@ -0,0 +1,28 @@
+use std::rc::Rc;
+
+/// Value an expression evaluates to. Strings are shared, so cloning a Value never copies text.
+#[derive(Debug, PartialEq, Clone)]
+pub enum Value {
+    Nil,
+    Boolean(bool),
+    Number(f64),
+    String(Rc<str>),
+}
+
+impl Value {
+    /// false and nil are falsey, everything else is truthy.
+    pub fn is_truthy(&self) -> bool {
+        !matches!(self, Value::Nil | Value::Boolean(false))
+    }
+}
+
+impl std::fmt::Display for Value {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            Value::Nil => f.write_str("nil"),
+            Value::Boolean(b) => b.fmt(f),
+            Value::Number(n) => n.fmt(f),
+            Value::String(s) => f.write_str(s),
+        }
+    }
+}